@@ -0,0 +1,164 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "BlockReader.h"
+
+#include <algorithm>
+
+namespace Peaks
+{
+	BlockReader::BlockReader(size_t blockSize) :
+		m_blockSize(blockSize),
+		m_remaining(0),
+		m_nextBuffer(0),
+		m_holding(false),
+		m_done(true),
+		m_failed(false),
+		m_stopping(false)
+	{
+		for (size_t i = 0; i < 2; ++i)
+		{
+			m_buffers[i].resize(m_blockSize);
+			m_lengths[i] = 0;
+			m_full[i] = false;
+		}
+	}
+
+	BlockReader::~BlockReader()
+	{
+		close();
+	}
+
+	bool BlockReader::open(const std::string& fileName, uint64_t offset, uint64_t length)
+	{
+		close();
+
+		m_file.open(fileName, std::ios::binary);
+		if (!m_file)
+			return false;
+		m_file.seekg((std::streamoff)offset);
+		if (!m_file)
+			return false;
+
+		m_remaining = length;
+		m_nextBuffer = 0;
+		m_holding = false;
+		m_done = false;
+		m_failed = false;
+		m_stopping = false;
+		m_full[0] = m_full[1] = false;
+		m_thread = std::thread(&BlockReader::run, this);
+		return true;
+	}
+
+	void BlockReader::close()
+	{
+		if (m_thread.joinable())
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_stopping = true;
+			}
+			m_changed.notify_all();
+			m_thread.join();
+		}
+		if (m_file.is_open())
+			m_file.close();
+		m_file.clear();
+		m_done = true;
+	}
+
+	// Reader thread: fills whichever buffer the caller isn't using, in turn.
+	void BlockReader::run()
+	{
+		size_t buffer = 0;
+
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_changed.wait(lock, [this, buffer] { return m_stopping || !m_full[buffer]; });
+				if (m_stopping)
+					return;
+			}
+
+			// The buffer is ours until it's marked full, so read without holding the lock.
+			size_t toRead = (size_t)std::min((uint64_t)m_blockSize, m_remaining);
+			size_t numRead = 0;
+			bool failed = false;
+
+			if (toRead > 0)
+			{
+				m_file.read(m_buffers[buffer].data(), toRead);
+				numRead = (size_t)m_file.gcount();
+				failed = m_file.bad();
+				m_remaining -= numRead;
+			}
+
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_lengths[buffer] = numRead;
+				m_full[buffer] = true;
+				m_failed = failed;
+			}
+			m_changed.notify_all();
+
+			// A short read is the end of the file (or range).
+			if (numRead < m_blockSize || failed)
+				return;
+			buffer ^= 1;
+		}
+	}
+
+	bool BlockReader::next(const char*& data, size_t& dataLen)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		// Give back the block handed out last time so the reader can refill it.
+		if (m_holding)
+		{
+			m_full[m_nextBuffer ^ 1] = false;
+			m_holding = false;
+			m_changed.notify_all();
+		}
+		if (m_done)
+			return false;
+
+		m_changed.wait(lock, [this] { return m_full[m_nextBuffer]; });
+
+		if (m_lengths[m_nextBuffer] == 0)
+		{
+			m_done = true;
+			return false;
+		}
+
+		data = m_buffers[m_nextBuffer].data();
+		dataLen = m_lengths[m_nextBuffer];
+		m_holding = true;
+
+		// The reader stops after a short block, so that's the last one.
+		if (dataLen < m_blockSize || m_failed)
+			m_done = true;
+		m_nextBuffer ^= 1;
+		return true;
+	}
+}
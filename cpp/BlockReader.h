@@ -0,0 +1,87 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#ifndef _BLOCKREADER_
+#define _BLOCKREADER_
+
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Peaks
+{
+	/**
+	 * Reads a range of a file in fixed-size blocks, double buffered: a background thread reads the next block while the
+	 * caller works on the current one. Only two blocks are ever held in memory, whatever the size of the file.
+	 */
+	class BlockReader
+	{
+	public:
+		BlockReader(size_t blockSize);
+		~BlockReader();
+
+		/**
+		 * Starts reading length bytes (or up to the end of the file) from offset. Returns false if the file can't be opened.
+		 */
+		bool open(const std::string& fileName, uint64_t offset = 0, uint64_t length = UINT64_MAX);
+		void close();
+
+		/**
+		 * Waits for the next block and returns it. The block stays valid until the next call. Returns false at the end of
+		 * the range or if a read fails, which failed() tells apart.
+		 */
+		bool next(const char*& data, size_t& dataLen);
+
+		bool failed() const { return m_failed; }
+
+	private:
+		BlockReader(const BlockReader&);
+		BlockReader& operator=(const BlockReader&);
+
+		size_t m_blockSize;
+		std::ifstream m_file;
+		uint64_t m_remaining;
+
+		std::vector<char> m_buffers[2];
+		size_t m_lengths[2];
+		bool m_full[2];       // Buffer has been read and not yet released by the caller
+		size_t m_nextBuffer;  // Next buffer to hand to the caller
+		bool m_holding;       // The caller has the buffer before m_nextBuffer
+		bool m_done;          // The reader has reached the end of the range
+		bool m_failed;
+		bool m_stopping;
+
+		std::thread m_thread;
+		std::mutex m_mutex;
+		std::condition_variable m_changed;
+
+		void run();
+	};
+}
+
+#endif
@@ -0,0 +1,88 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#ifndef _BUFFERPOOL_
+#define _BUFFERPOOL_
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Peaks
+{
+	/**
+	 * Thread-safe free list of reusable objects, such as peak lists or CSV loaders, so that a long-running process that
+	 * handles one job after another keeps reusing the memory the earlier jobs grew into rather than allocating it again.
+	 * Objects are handed back in whatever state they were left in; it's up to the user to clear them.
+	 */
+	template <typename T>
+	class BufferPool
+	{
+	public:
+		/**
+		 * At most maxFree objects are kept; any more that are released are deleted.
+		 */
+		BufferPool(size_t maxFree = 64) : m_maxFree(maxFree), m_numCreated(0) {}
+
+		/**
+		 * Returns a free object, or a new one made with the given function if there aren't any.
+		 */
+		template <typename Factory>
+		std::unique_ptr<T> acquire(Factory create)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+
+				if (!m_free.empty())
+				{
+					std::unique_ptr<T> object = std::move(m_free.back());
+					m_free.pop_back();
+					return object;
+				}
+				++m_numCreated;
+			}
+			return std::unique_ptr<T>(create());
+		}
+
+		std::unique_ptr<T> acquire() { return acquire([] { return new T(); }); }
+
+		void release(std::unique_ptr<T> object)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			if (object && (m_free.size() < m_maxFree))
+				m_free.push_back(std::move(object));
+		}
+
+		size_t numCreated() const { std::unique_lock<std::mutex> lock(m_mutex); return m_numCreated; }
+		size_t numFree() const { std::unique_lock<std::mutex> lock(m_mutex); return m_free.size(); }
+
+	private:
+		size_t m_maxFree;
+		size_t m_numCreated;
+		std::vector<std::unique_ptr<T>> m_free;
+		mutable std::mutex m_mutex;
+	};
+}
+
+#endif
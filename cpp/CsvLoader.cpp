@@ -0,0 +1,284 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "CsvLoader.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <string.h>
+
+#if defined(__has_include)
+#if __has_include(<charconv>) && (__cplusplus >= 201703L)
+#include <charconv>
+#endif
+#endif
+
+#if defined(__cpp_lib_to_chars) && (__cpp_lib_to_chars >= 201611L)
+#define PEAKS_HAVE_FROM_CHARS 1
+#endif
+
+namespace Peaks
+{
+	static const size_t SEGMENTS_PER_THREAD = 4; // Extra segments even out the load when line lengths vary
+
+	// Returns the start of the line after the one containing pos.
+	static const char* nextLine(const char* pos, const char* end)
+	{
+		const char* newline = (const char*)memchr(pos, '\n', end - pos);
+		return newline ? (newline + 1) : end;
+	}
+
+	// A line is blank if it only has whitespace on it.
+	static bool isBlankLine(const char* start, const char* end)
+	{
+		for (const char* pos = start; pos < end; ++pos)
+		{
+			if ((*pos != ' ') && (*pos != '\t') && (*pos != '\r') && (*pos != '\n'))
+				return false;
+		}
+		return true;
+	}
+
+	static size_t countRows(const char* start, const char* end)
+	{
+		size_t numRows = 0;
+
+		while (start < end)
+		{
+			const char* lineEnd = nextLine(start, end);
+
+			if (!isBlankLine(start, lineEnd))
+				++numRows;
+			start = lineEnd;
+		}
+		return numRows;
+	}
+
+	// Parses the number at the start of [pos, end), stopping at the end of the field. Returns zero if there isn't one.
+	static double parseField(const char* pos, const char* end)
+	{
+		while ((pos < end) && ((*pos == ' ') || (*pos == '\t')))
+			++pos;
+		if ((pos < end) && (*pos == '+'))
+			++pos;
+
+		double value = (double)0.0;
+
+#ifdef PEAKS_HAVE_FROM_CHARS
+		std::from_chars(pos, end, value);
+#else
+		// strtod needs a terminated string and the mapped file isn't one.
+		char field[64];
+		size_t len = std::min((size_t)(end - pos), sizeof(field) - 1);
+
+		memcpy(field, pos, len);
+		field[len] = '\0';
+		value = strtod(field, NULL);
+#endif
+		return value;
+	}
+
+	CsvLoader::CsvLoader(size_t numColumns, size_t numHeaderRows, size_t numThreads) :
+		m_numColumns(numColumns),
+		m_numHeaderRows(numHeaderRows),
+		m_numThreads(numThreads),
+		m_numRows(0),
+		m_capacity(0)
+#ifdef PEAKS_HAVE_PMR
+		, m_resource(NULL)
+#endif
+	{
+		if (m_numThreads == 0)
+			m_numThreads = ThreadPool::defaultNumThreads();
+	}
+
+#ifdef PEAKS_HAVE_PMR
+	CsvLoader::CsvLoader(std::pmr::memory_resource* resource, size_t numColumns, size_t numHeaderRows, size_t numThreads) :
+		m_numColumns(numColumns),
+		m_numHeaderRows(numHeaderRows),
+		m_numThreads(numThreads),
+		m_numRows(0),
+		m_capacity(0),
+		m_resource(resource)
+	{
+		if (m_numThreads == 0)
+			m_numThreads = ThreadPool::defaultNumThreads();
+	}
+#endif
+
+	CsvLoader::~CsvLoader()
+	{
+		release();
+	}
+
+	void CsvLoader::release()
+	{
+		for (auto iter = m_columns.begin(); iter != m_columns.end(); ++iter)
+		{
+#ifdef PEAKS_HAVE_PMR
+			if (m_resource)
+			{
+				m_resource->deallocate((*iter), m_capacity * sizeof(double), alignof(double));
+				continue;
+			}
+#endif
+			delete[] (*iter);
+		}
+		m_columns.clear();
+		m_capacity = 0;
+		m_numRows = 0;
+	}
+
+	bool CsvLoader::parseLine(const char* start, const char* end, size_t numColumns, double* values)
+	{
+		if (isBlankLine(start, end))
+			return false;
+
+		const char* field = start;
+
+		for (size_t column = 0; column < numColumns; ++column)
+		{
+			const char* fieldEnd = (field < end) ? (const char*)memchr(field, ',', end - field) : NULL;
+
+			if (!fieldEnd)
+				fieldEnd = end;
+			values[column] = parseField(field, fieldEnd);
+			field = std::min(fieldEnd + 1, end);
+		}
+		return true;
+	}
+
+	// Makes sure there's a buffer with room for m_numRows rows for each column.
+	void CsvLoader::reserveRows()
+	{
+		if (m_numRows > m_capacity)
+		{
+			size_t numRows = m_numRows;
+
+			release();
+			m_numRows = numRows;
+			m_capacity = numRows;
+		}
+		while (m_columns.size() < m_numColumns)
+			m_columns.push_back(allocateColumn());
+	}
+
+	double* CsvLoader::allocateColumn()
+	{
+#ifdef PEAKS_HAVE_PMR
+		if (m_resource)
+			return (double*)m_resource->allocate(m_capacity * sizeof(double), alignof(double));
+#endif
+		return new double[m_capacity];
+	}
+
+	// Parses the rows in [start, end), which begins at the start of a line, into the column buffers from firstRow on.
+	void CsvLoader::parseRows(const char* start, const char* end, size_t firstRow)
+	{
+		std::vector<double> values(m_numColumns);
+		size_t row = firstRow;
+
+		while (start < end)
+		{
+			const char* lineEnd = nextLine(start, end);
+
+			if (CsvLoader::parseLine(start, lineEnd, m_numColumns, values.data()))
+			{
+				for (size_t column = 0; column < m_numColumns; ++column)
+					m_columns[column][row] = values[column];
+				++row;
+			}
+			start = lineEnd;
+		}
+	}
+
+	void CsvLoader::setLayout(size_t numColumns, size_t numHeaderRows)
+	{
+		m_numColumns = numColumns;
+		m_numHeaderRows = numHeaderRows;
+	}
+
+	bool CsvLoader::load(const std::string& fileName)
+	{
+		MappedFile file;
+
+		m_numRows = 0;
+
+		if (!file.open(fileName))
+			return false;
+
+		const char* start = file.data();
+		const char* end = start + file.size();
+
+		// Skip the header.
+		for (size_t row = 0; (row < m_numHeaderRows) && (start < end); ++row)
+			start = nextLine(start, end);
+
+		// Split the rest of the file into segments that start at the beginning of a line.
+		size_t numSegments = std::max((size_t)1, std::min(m_numThreads * SEGMENTS_PER_THREAD, (size_t)(end - start) / 4096));
+		std::vector<const char*> bounds(numSegments + 1, end);
+
+		bounds[0] = start;
+		for (size_t segment = 1; segment < numSegments; ++segment)
+		{
+			const char* pos = start + ((end - start) / numSegments) * segment;
+			bounds[segment] = std::max(nextLine(pos - 1, end), bounds[segment - 1]);
+		}
+
+		// A single segment is parsed on this thread.
+		if (numSegments == 1)
+		{
+			m_numRows = countRows(start, end);
+			reserveRows();
+			parseRows(start, end, 0);
+			return true;
+		}
+
+		ThreadPool pool(std::min(m_numThreads, numSegments));
+
+		// Count the rows in each segment so that each one knows where its rows go, then parse them straight into place.
+		std::vector<size_t> firstRows(numSegments + 1, 0);
+		for (size_t segment = 0; segment < numSegments; ++segment)
+		{
+			pool.submit([&, segment]() {
+				firstRows[segment + 1] = countRows(bounds[segment], bounds[segment + 1]);
+			});
+		}
+		pool.wait();
+
+		for (size_t segment = 0; segment < numSegments; ++segment)
+			firstRows[segment + 1] += firstRows[segment];
+		m_numRows = firstRows[numSegments];
+		reserveRows();
+
+		for (size_t segment = 0; segment < numSegments; ++segment)
+		{
+			pool.submit([&, segment]() {
+				parseRows(bounds[segment], bounds[segment + 1], firstRows[segment]);
+			});
+		}
+		pool.wait();
+
+		return true;
+	}
+}
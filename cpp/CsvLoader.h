@@ -0,0 +1,110 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#ifndef _CSVLOADER_
+#define _CSVLOADER_
+
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "MonotonicArena.h"
+
+namespace Peaks
+{
+	/**
+	 * Loads a numeric CSV file into one buffer per column. The file is memory mapped and split at line boundaries into
+	 * segments that are parsed in parallel, each writing straight into its rows of the column buffers.
+	 *
+	 * Every row is expected to have numColumns comma separated numbers. Fields that are missing or can't be parsed are
+	 * read as zero and extra fields are ignored. Blank lines are skipped, as are the given number of header rows at the
+	 * start of the file.
+	 */
+	class CsvLoader
+	{
+	public:
+		/**
+		 * Zero threads means one per hardware thread.
+		 */
+		CsvLoader(size_t numColumns, size_t numHeaderRows = 0, size_t numThreads = 0);
+
+#ifdef PEAKS_HAVE_PMR
+		/**
+		 * Same as above, but the column buffers come from the given memory resource, such as a MonotonicArena that is
+		 * reset between jobs, instead of the heap. The resource has to outlive the buffers: call release() before
+		 * resetting an arena the loader has allocated from.
+		 */
+		CsvLoader(std::pmr::memory_resource* resource, size_t numColumns, size_t numHeaderRows = 0, size_t numThreads = 0);
+#endif
+
+		~CsvLoader();
+
+		/**
+		 * Returns false if the file can't be read, in which case there are no rows. The column buffers are kept from one
+		 * load to the next and only grow, so a loader that's reused doesn't allocate for files no bigger than before.
+		 */
+		bool load(const std::string& fileName);
+
+		/**
+		 * Changes the number of columns and header rows for the next load.
+		 */
+		void setLayout(size_t numColumns, size_t numHeaderRows);
+
+		size_t numRows() const { return m_numRows; }
+		size_t numColumns() const { return m_numColumns; }
+
+		const double* column(size_t index) const { return m_columns.at(index); }
+
+		/**
+		 * Frees the column buffers. The loader has no rows until the next load.
+		 */
+		void release();
+
+		/**
+		 * Parses one line, with or without its line ending, into numColumns values using the same rules as load().
+		 * Returns false, leaving the values alone, if the line is blank.
+		 */
+		static bool parseLine(const char* start, const char* end, size_t numColumns, double* values);
+
+	private:
+		size_t m_numColumns;
+		size_t m_numHeaderRows;
+		size_t m_numThreads;
+		size_t m_numRows;
+		size_t m_capacity; // Rows each column buffer has room for
+		std::vector<double*> m_columns;
+#ifdef PEAKS_HAVE_PMR
+		std::pmr::memory_resource* m_resource; // NULL to allocate with new[]
+#endif
+
+		CsvLoader(const CsvLoader&);
+		CsvLoader& operator=(const CsvLoader&);
+
+		double* allocateColumn();
+		void reserveRows();
+		void parseRows(const char* start, const char* end, size_t firstRow);
+	};
+}
+
+#endif
@@ -0,0 +1,433 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "JobServer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PEAKS_HAVE_UNIX_SOCKETS 1
+#include <errno.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace Peaks
+{
+	static const size_t DEFAULT_CSV_COLUMNS = 4; // timestamp, x, y, z
+
+	void JobDescription::clear()
+	{
+		id.clear();
+		fileType = FILE_TYPE_CSV;
+		fileName.clear();
+		overStd = false;
+		threshold = (double)0.0;
+		sigmas = (double)1.0;
+		numColumns = DEFAULT_CSV_COLUMNS;
+		numHeaderRows = 0;
+		dataType = SampleFile::DATA_TYPE_FLOAT64;
+		numChannels = 1;
+		layout = SampleFile::LAYOUT_INTERLEAVED;
+	}
+
+	// Parses a non-negative integer, the whole of the string.
+	static bool parseCount(const std::string& str, size_t& value)
+	{
+		char* end = NULL;
+
+		if (str.empty() || (str[0] == '-'))
+			return false;
+		value = (size_t)strtoull(str.c_str(), &end, 10);
+		return (*end == '\0');
+	}
+
+	static bool parseNumber(const std::string& str, double& value)
+	{
+		char* end = NULL;
+
+		if (str.empty())
+			return false;
+		value = strtod(str.c_str(), &end);
+		return (*end == '\0');
+	}
+
+	bool JobDescription::parse(const std::string& line, std::string& error)
+	{
+		std::istringstream fields(line);
+		std::string field;
+
+		clear();
+
+		while (fields >> field)
+		{
+			size_t equals = field.find('=');
+			std::string key = field.substr(0, equals);
+			std::string value = (equals == std::string::npos) ? "" : field.substr(equals + 1);
+			bool valid = true;
+
+			if (equals == std::string::npos)
+				valid = false;
+			else if (key == "id")
+				id = value;
+			else if ((key == "csv") || (key == "npy") || (key == "binary"))
+			{
+				fileType = (key == "csv") ? FILE_TYPE_CSV : ((key == "npy") ? FILE_TYPE_NPY : FILE_TYPE_BINARY);
+				fileName = value;
+			}
+			else if (key == "threshold")
+			{
+				valid = parseNumber(value, threshold);
+				overStd = false;
+			}
+			else if (key == "sigmas")
+			{
+				valid = parseNumber(value, sigmas);
+				overStd = true;
+			}
+			else if (key == "columns")
+				valid = parseCount(value, numColumns) && (numColumns > 0);
+			else if (key == "header-rows")
+				valid = parseCount(value, numHeaderRows);
+			else if (key == "dtype")
+				valid = SampleFile::parseDataType(value, dataType);
+			else if (key == "channels")
+				valid = parseCount(value, numChannels) && (numChannels > 0);
+			else if (key == "layout")
+				valid = SampleFile::parseLayout(value, layout);
+			else
+				valid = false;
+
+			if (!valid)
+			{
+				error = "Invalid field " + field;
+				return false;
+			}
+		}
+
+		if (id.empty())
+		{
+			error = "The job has no id";
+			return false;
+		}
+		if (fileName.empty())
+		{
+			error = "The job has no csv, npy or binary file";
+			return false;
+		}
+		return true;
+	}
+
+	// The output of one input stream, which the jobs read from it take turns writing to.
+	class JobServer::Session
+	{
+	public:
+		PeakWriter writer;
+		std::mutex mutex;
+		std::condition_variable finished;
+		size_t numRunning;
+		bool failed;
+
+		Session(FILE* out, PeakWriter::Format format) : writer(out, format), numRunning(0), failed(false) {}
+
+		// Reports a job that didn't run.
+		void reject(const std::string& id, const std::string& error)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+
+			writer.beginJob(id);
+			writer.endJob(0, error);
+			failed = !writer.flush() || failed;
+		}
+	};
+
+	class JobServer::Job
+	{
+	public:
+		JobDescription description;
+		Session& session;
+		std::unique_ptr<CsvLoader> loader;
+		SampleFile file;
+		std::vector<std::unique_ptr<GraphPeakList>> peaks; // One list per channel
+		std::atomic<size_t> numRemaining;                  // Channels still to be searched
+		std::string error;
+
+		Job(const JobDescription& newDescription, Session& newSession) :
+			description(newDescription),
+			session(newSession),
+			numRemaining(0)
+		{
+		}
+	};
+
+	JobServer::JobServer(PeakWriter::Format format, size_t numThreads) :
+		m_format(format),
+		m_pool(numThreads)
+	{
+	}
+
+	// Reads a line of any length, without its line ending. Returns false at the end of the file.
+	static bool readLine(FILE* in, std::string& line)
+	{
+		char buffer[4096];
+
+		line.clear();
+		while (fgets(buffer, sizeof(buffer), in))
+		{
+			line.append(buffer);
+			if (line[line.length() - 1] == '\n')
+			{
+				line.erase(line.find_last_not_of("\r\n") + 1);
+				return true;
+			}
+		}
+		return !line.empty();
+	}
+
+	bool JobServer::serve(FILE* in, FILE* out)
+	{
+		Session session(out, m_format);
+		std::string line;
+
+		while (readLine(in, line))
+		{
+			size_t first = line.find_first_not_of(" \t");
+
+			if ((first == std::string::npos) || (line[first] == '#'))
+				continue;
+
+			JobDescription description;
+			std::string error;
+
+			if (!description.parse(line, error))
+			{
+				session.reject(description.id, error);
+				continue;
+			}
+
+			{
+				std::unique_lock<std::mutex> lock(session.mutex);
+				++session.numRunning;
+			}
+
+			std::shared_ptr<Job> job(new Job(description, session));
+			m_pool.submit([this, job]() { start(job); });
+		}
+
+		std::unique_lock<std::mutex> lock(session.mutex);
+		session.finished.wait(lock, [&session] { return session.numRunning == 0; });
+		return !session.failed;
+	}
+
+	// Loads the job's file, then queues a search of each of its channels. Tasks queued from a worker go on that worker's
+	// own queue, so the channels are searched while the file is still in its cache, unless another worker is idle.
+	void JobServer::start(std::shared_ptr<Job> job)
+	{
+		const JobDescription& description = job->description;
+		size_t numChannels = 0;
+
+		if (description.fileType == JobDescription::FILE_TYPE_CSV)
+		{
+			job->loader = m_loaders.acquire([]() { return new CsvLoader(DEFAULT_CSV_COLUMNS, 0, 1); });
+			job->loader->setLayout(description.numColumns, description.numHeaderRows);
+
+			if (job->loader->load(description.fileName))
+				numChannels = description.numColumns - 1;
+			else
+				job->error = "Failed to read " + description.fileName;
+		}
+		else
+		{
+			bool opened;
+
+			if (description.fileType == JobDescription::FILE_TYPE_NPY)
+				opened = job->file.openNpy(description.fileName);
+			else
+				opened = job->file.openRaw(description.fileName, description.dataType, description.numChannels, description.layout);
+
+			if (opened)
+				numChannels = job->file.numChannels();
+			else
+				job->error = "Failed to open the file: " + job->file.error();
+		}
+
+		if (numChannels == 0)
+		{
+			finish(*job);
+			return;
+		}
+
+		for (size_t channel = 0; channel < numChannels; ++channel)
+			job->peaks.push_back(m_peakLists.acquire());
+
+		job->numRemaining = numChannels;
+		for (size_t channel = 0; channel < numChannels; ++channel)
+		{
+			m_pool.submit([this, job, channel]() {
+				findPeaks(*job, channel);
+				if (--job->numRemaining == 0)
+					finish(*job);
+			});
+		}
+	}
+
+	template <typename T>
+	static void findPeaksInView(const SampleView<T>& view, const JobDescription& description, GraphPeakList& peaks)
+	{
+		if (description.overStd)
+			Peaks::findPeaksOverStd(view, peaks, description.sigmas);
+		else
+			Peaks::findPeaksOverThreshold(view, peaks, description.threshold);
+	}
+
+	// Searches one channel, into the job's list for it.
+	void JobServer::findPeaks(Job& job, size_t channel)
+	{
+		GraphPeakList& peaks = *job.peaks[channel];
+
+		if (job.loader)
+			findPeaksInView(makeSampleView(job.loader->column(channel + 1), job.loader->numRows()), job.description, peaks);
+		else if (job.file.dataType() == SampleFile::DATA_TYPE_FLOAT32)
+			findPeaksInView(job.file.channel<float>(channel), job.description, peaks);
+		else
+			findPeaksInView(job.file.channel<double>(channel), job.description, peaks);
+	}
+
+	// Writes the job's results and hands its buffers back.
+	void JobServer::finish(Job& job)
+	{
+		Session& session = job.session;
+
+		{
+			std::unique_lock<std::mutex> lock(session.mutex);
+			size_t numPeaks = 0;
+
+			session.writer.beginJob(job.description.id);
+			for (size_t channel = 0; channel < job.peaks.size(); ++channel)
+			{
+				const GraphPeakList& peaks = *job.peaks[channel];
+
+				session.writer.beginChannel();
+				for (auto iter = peaks.begin(); iter != peaks.end(); ++iter)
+					session.writer.write(channel, (*iter));
+				session.writer.endChannel();
+				numPeaks += peaks.size();
+			}
+			session.writer.endJob(numPeaks, job.error);
+			session.failed = !session.writer.flush() || session.failed;
+		}
+
+		for (auto iter = job.peaks.begin(); iter != job.peaks.end(); ++iter)
+			m_peakLists.release(std::move(*iter));
+		job.peaks.clear();
+		m_loaders.release(std::move(job.loader));
+		job.file.close();
+
+		// The session may go away as soon as the count reaches zero, so this is the last use of it.
+		std::unique_lock<std::mutex> lock(session.mutex);
+		if (--session.numRunning == 0)
+			session.finished.notify_all();
+	}
+
+	bool JobServer::listen(const std::string& path, std::string& error)
+	{
+#ifdef PEAKS_HAVE_UNIX_SOCKETS
+		struct sockaddr_un address;
+
+		if (path.length() >= sizeof(address.sun_path))
+		{
+			error = "The socket path is too long";
+			return false;
+		}
+
+		int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (listener < 0)
+		{
+			error = strerror(errno);
+			return false;
+		}
+
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+		// Only a socket left behind by an earlier server is replaced, never a regular file.
+		struct stat status;
+		if ((stat(path.c_str(), &status) == 0) && S_ISSOCK(status.st_mode))
+			unlink(path.c_str());
+
+		if ((bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0) || (::listen(listener, SOMAXCONN) != 0))
+		{
+			error = strerror(errno);
+			close(listener);
+			return false;
+		}
+
+		// A client that hangs up early shouldn't take the server down with it.
+		signal(SIGPIPE, SIG_IGN);
+
+		while (true)
+		{
+			int connection = accept(listener, NULL, NULL);
+
+			if (connection < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				error = strerror(errno);
+				close(listener);
+				return false;
+			}
+
+			std::thread([this, connection]() {
+				FILE* in = fdopen(connection, "r");
+				int outConnection = dup(connection);
+				FILE* out = (outConnection >= 0) ? fdopen(outConnection, "w") : NULL;
+
+				if (in && out)
+					serve(in, out);
+				if (out)
+					fclose(out);
+				else if (outConnection >= 0)
+					close(outConnection);
+				if (in)
+					fclose(in);
+				else
+					close(connection);
+			}).detach();
+		}
+#else
+		error = "Unix domain sockets aren't supported on this platform";
+		return false;
+#endif
+	}
+}
@@ -0,0 +1,128 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#ifndef _JOBSERVER_
+#define _JOBSERVER_
+
+#include <stdio.h>
+#include <memory>
+#include <string>
+
+#include "BufferPool.h"
+#include "CsvLoader.h"
+#include "PeakWriter.h"
+#include "Peaks.h"
+#include "SampleFile.h"
+#include "ThreadPool.h"
+
+namespace Peaks
+{
+	/**
+	 * One job for the JobServer: a file to search and how to search it. Jobs are written as a line of key=value pairs
+	 * separated by spaces, named after the example program's options:
+	 *
+	 *   id=<job ID> csv=<file>|npy=<file>|binary=<file> [threshold=<value>|sigmas=<value>] [columns=<n>]
+	 *   [header-rows=<n>] [dtype=f64|f32] [channels=<n>] [layout=interleaved|planar]
+	 *
+	 * As with the example program, the first column of a CSV file is the timestamp and the others are channels.
+	 */
+	class JobDescription
+	{
+	public:
+		typedef enum FileType
+		{
+			FILE_TYPE_CSV = 0,
+			FILE_TYPE_NPY,
+			FILE_TYPE_BINARY
+		} FileType;
+
+		std::string id;
+		FileType fileType;
+		std::string fileName;
+		bool overStd;     // Search above sigmas standard deviations over the mean rather than above threshold
+		double threshold;
+		double sigmas;
+		size_t numColumns;
+		size_t numHeaderRows;
+		SampleFile::DataType dataType;
+		size_t numChannels;
+		SampleFile::Layout layout;
+
+		JobDescription() { clear(); }
+
+		void clear();
+
+		/**
+		 * Returns false, with the reason in error, if the line isn't a valid job. The ID is set if the line has one,
+		 * even so, so that the error can be reported against it.
+		 */
+		bool parse(const std::string& line, std::string& error);
+	};
+
+	/**
+	 * Runs peak finding jobs for a long-lived process, so that the cost of starting up is paid once rather than per file.
+	 * Each job is loaded on a worker of a work-stealing ThreadPool, which then queues a task per channel on its own
+	 * queue for idle workers to steal. The results of each job are written, tagged with its ID (see PeakWriter::beginJob),
+	 * as soon as its last channel is done. The CSV loaders and peak lists are reused from job to job through BufferPools.
+	 */
+	class JobServer
+	{
+	public:
+		/**
+		 * The format has to be one that supports jobs. Zero threads means one per hardware thread.
+		 */
+		JobServer(PeakWriter::Format format, size_t numThreads = 0);
+
+		/**
+		 * Runs the jobs read from in, one per line, until the end of it, writing the results to out in the order the jobs
+		 * finish. Blank lines and lines that start with # are skipped. Returns once every job has finished; false if out
+		 * had a write error.
+		 */
+		bool serve(FILE* in, FILE* out);
+
+		/**
+		 * Listens on a Unix domain socket at the given path, replacing any socket already there, and serves each connection
+		 * as above, concurrently. Only returns if the socket can't be set up, with the reason in error.
+		 */
+		bool listen(const std::string& path, std::string& error);
+
+		const ThreadPool& pool() const { return m_pool; }
+		size_t numLoadersCreated() const { return m_loaders.numCreated(); }
+		size_t numPeakListsCreated() const { return m_peakLists.numCreated(); }
+
+	private:
+		class Session;
+		class Job;
+
+		PeakWriter::Format m_format;
+		ThreadPool m_pool;
+		BufferPool<CsvLoader> m_loaders;
+		BufferPool<GraphPeakList> m_peakLists;
+
+		void start(std::shared_ptr<Job> job);
+		void findPeaks(Job& job, size_t channel);
+		void finish(Job& job);
+	};
+}
+
+#endif
@@ -0,0 +1,116 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "MappedFile.h"
+
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PEAKS_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Peaks
+{
+	MappedFile::MappedFile() :
+		m_data(NULL),
+		m_size(0),
+		m_open(false),
+		m_mapped(false)
+	{
+	}
+
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	bool MappedFile::open(const std::string& fileName)
+	{
+		close();
+
+#ifdef PEAKS_HAVE_MMAP
+		int fd = ::open(fileName.c_str(), O_RDONLY);
+		if (fd < 0)
+			return false;
+
+		struct stat info;
+		if (fstat(fd, &info) != 0)
+		{
+			::close(fd);
+			return false;
+		}
+
+		m_size = (size_t)info.st_size;
+		if (m_size > 0)
+		{
+			void* addr = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+			if (addr != MAP_FAILED)
+			{
+				// The whole file is about to be read, most likely front to back.
+				madvise(addr, m_size, MADV_SEQUENTIAL);
+				madvise(addr, m_size, MADV_WILLNEED);
+				m_data = (const char*)addr;
+				m_mapped = true;
+			}
+		}
+		::close(fd);
+
+		if (m_mapped || m_size == 0)
+		{
+			m_open = true;
+			return true;
+		}
+		m_size = 0;
+#endif
+
+		// Fall back to reading the file.
+		std::ifstream infile(fileName, std::ios::binary);
+		if (!infile)
+			return false;
+
+		m_buffer.assign(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+		m_data = m_buffer.data();
+		m_size = m_buffer.size();
+		m_open = true;
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+#ifdef PEAKS_HAVE_MMAP
+		if (m_mapped)
+			munmap((void*)m_data, m_size);
+#endif
+		m_buffer.clear();
+		m_buffer.shrink_to_fit();
+		m_data = NULL;
+		m_size = 0;
+		m_open = false;
+		m_mapped = false;
+	}
+}
@@ -0,0 +1,65 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#ifndef _MAPPEDFILE_
+#define _MAPPEDFILE_
+
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+namespace Peaks
+{
+	/**
+	 * Read-only view of a whole file. The file is memory mapped where that's supported and read into memory otherwise.
+	 */
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+
+		/**
+		 * Returns false if the file can't be opened or mapped. An empty file opens successfully with a size of zero.
+		 */
+		bool open(const std::string& fileName);
+		void close();
+
+		const char* data() const { return m_data; }
+		size_t size() const { return m_size; }
+		bool isOpen() const { return m_open; }
+
+	private:
+		MappedFile(const MappedFile&);
+		MappedFile& operator=(const MappedFile&);
+
+		const char* m_data;
+		size_t m_size;
+		bool m_open;
+		bool m_mapped;
+		std::vector<char> m_buffer; // File contents, when it couldn't be mapped
+	};
+}
+
+#endif
@@ -0,0 +1,121 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "MonotonicArena.h"
+
+#ifdef PEAKS_HAVE_PMR
+
+#include <stdint.h>
+#include <new>
+
+namespace Peaks
+{
+	MonotonicArena::MonotonicArena(size_t chunkSize) :
+		m_chunkSize(chunkSize > 0 ? chunkSize : DEFAULT_CHUNK_SIZE),
+		m_current(0),
+		m_used(0),
+		m_bytesAllocated(0)
+	{
+	}
+
+	MonotonicArena::~MonotonicArena()
+	{
+		freeChunks();
+	}
+
+	size_t MonotonicArena::capacity() const
+	{
+		size_t total = 0;
+
+		for (auto iter = m_chunks.begin(); iter != m_chunks.end(); ++iter)
+			total += (*iter).size;
+		return total;
+	}
+
+	void MonotonicArena::freeChunks()
+	{
+		for (auto iter = m_chunks.begin(); iter != m_chunks.end(); ++iter)
+			::operator delete((*iter).data);
+		m_chunks.clear();
+	}
+
+	// Appends a chunk of at least minSize bytes. Chunks double in size, so there are few of them however much is allocated.
+	void MonotonicArena::addChunk(size_t minSize)
+	{
+		Chunk chunk;
+
+		chunk.size = (m_chunkSize > minSize) ? m_chunkSize : minSize;
+		chunk.data = (char*)::operator new(chunk.size);
+		m_chunks.push_back(chunk);
+		m_chunkSize = chunk.size * 2;
+	}
+
+	void MonotonicArena::reset()
+	{
+		if (m_chunks.size() > 1)
+		{
+			size_t total = capacity();
+
+			freeChunks();
+			m_chunkSize = total;
+			addChunk(total);
+		}
+		m_current = 0;
+		m_used = 0;
+		m_bytesAllocated = 0;
+	}
+
+	void* MonotonicArena::do_allocate(size_t bytes, size_t alignment)
+	{
+		while (true)
+		{
+			if (m_current < m_chunks.size())
+			{
+				Chunk& chunk = m_chunks[m_current];
+				uintptr_t start = (uintptr_t)(chunk.data + m_used);
+				size_t padding = (size_t)((alignment - (start % alignment)) % alignment);
+
+				if ((m_used + padding <= chunk.size) && (bytes <= chunk.size - m_used - padding))
+				{
+					char* result = chunk.data + m_used + padding;
+
+					m_used += padding + bytes;
+					m_bytesAllocated += bytes;
+					return result;
+				}
+
+				// Move on to the next chunk, if there is one, leaving the rest of this one unused until the next reset.
+				if (m_current + 1 < m_chunks.size())
+				{
+					++m_current;
+					m_used = 0;
+					continue;
+				}
+			}
+
+			addChunk(bytes + alignment);
+			m_current = m_chunks.size() - 1;
+			m_used = 0;
+		}
+	}
+}
+
+#endif
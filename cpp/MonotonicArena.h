@@ -0,0 +1,98 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#ifndef _MONOTONICARENA_
+#define _MONOTONICARENA_
+
+#include <stdlib.h>
+#include <vector>
+
+#if defined(__has_include)
+#if __has_include(<memory_resource>) && (__cplusplus >= 201703L)
+#include <memory_resource>
+#endif
+#endif
+
+#if defined(__cpp_lib_memory_resource) && (__cpp_lib_memory_resource >= 201603L)
+#define PEAKS_HAVE_PMR 1
+#endif
+
+#ifdef PEAKS_HAVE_PMR
+
+namespace Peaks
+{
+	/**
+	 * Memory resource for allocations that all go away together, such as everything one job allocates. Allocating is
+	 * a pointer bump, freeing does nothing, and reset() frees everything at once but keeps the memory, so a process that
+	 * resets the arena between jobs stops asking the system for memory once it has run its largest job. Use it with the
+	 * std::pmr containers, e.g. Peaks::pmr::GraphPeakList, and CsvLoader.
+	 *
+	 * An arena isn't thread-safe, which is the point: give each thread its own and there's nothing to contend for.
+	 */
+	class MonotonicArena : public std::pmr::memory_resource
+	{
+	public:
+		static const size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+		MonotonicArena(size_t chunkSize = DEFAULT_CHUNK_SIZE);
+		~MonotonicArena();
+
+		/**
+		 * Frees everything allocated so far. If that took more than one chunk, they are merged into one big enough for all
+		 * of it, so that the next job of the same size fits in a single chunk.
+		 */
+		void reset();
+
+		size_t bytesAllocated() const { return m_bytesAllocated; } // Since the last reset
+		size_t capacity() const;                                   // Size of all of the chunks
+
+	protected:
+		void* do_allocate(size_t bytes, size_t alignment);
+		void do_deallocate(void*, size_t, size_t) {}
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept { return this == &other; }
+
+	private:
+		class Chunk
+		{
+		public:
+			char* data;
+			size_t size;
+		};
+
+		MonotonicArena(const MonotonicArena&);
+		MonotonicArena& operator=(const MonotonicArena&);
+
+		std::vector<Chunk> m_chunks;
+		size_t m_chunkSize;      // Size of the next chunk to be added
+		size_t m_current;        // Chunk being allocated from
+		size_t m_used;           // Bytes used in the current chunk
+		size_t m_bytesAllocated;
+
+		void addChunk(size_t minSize);
+		void freeChunks();
+	};
+}
+
+#endif
+
+#endif
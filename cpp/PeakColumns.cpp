@@ -0,0 +1,241 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "PeakColumns.h"
+#include "VectorScan.h"
+
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+namespace Peaks
+{
+	template <typename IndexType>
+	bool PeakColumns<IndexType>::assign(const GraphPeakList& peaks)
+	{
+		clear();
+		reserve(peaks.size());
+
+		for (auto iter = peaks.begin(); iter != peaks.end(); ++iter)
+		{
+			if (!append(*iter))
+			{
+				clear();
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template <typename IndexType>
+	bool PeakColumns<IndexType>::append(const GraphPeak& peak)
+	{
+		const uint64_t maxIndex = std::numeric_limits<IndexType>::max();
+
+		if ((peak.leftTrough.x > maxIndex) || (peak.peak.x > maxIndex) || (peak.rightTrough.x > maxIndex))
+			return false;
+
+		leftTroughX.push_back((IndexType)peak.leftTrough.x);
+		peakX.push_back((IndexType)peak.peak.x);
+		rightTroughX.push_back((IndexType)peak.rightTrough.x);
+		leftTroughY.push_back(peak.leftTrough.y);
+		peakY.push_back(peak.peak.y);
+		rightTroughY.push_back(peak.rightTrough.y);
+		area.push_back(peak.area);
+		return true;
+	}
+
+	template <typename IndexType>
+	GraphPeak PeakColumns<IndexType>::at(size_t row) const
+	{
+		GraphPeak peak;
+
+		peak.leftTrough = GraphPoint(leftTroughX[row], leftTroughY[row]);
+		peak.peak = GraphPoint(peakX[row], peakY[row]);
+		peak.rightTrough = GraphPoint(rightTroughX[row], rightTroughY[row]);
+		peak.area = area[row];
+		return peak;
+	}
+
+	template <typename IndexType>
+	GraphPeakList PeakColumns<IndexType>::toList() const
+	{
+		GraphPeakList peaks;
+
+		peaks.reserve(size());
+		for (size_t row = 0; row < size(); ++row)
+			peaks.push_back(at(row));
+		return peaks;
+	}
+
+	template <typename IndexType>
+	void PeakColumns<IndexType>::reserve(size_t numPeaks)
+	{
+		leftTroughX.reserve(numPeaks);
+		peakX.reserve(numPeaks);
+		rightTroughX.reserve(numPeaks);
+		leftTroughY.reserve(numPeaks);
+		peakY.reserve(numPeaks);
+		rightTroughY.reserve(numPeaks);
+		area.reserve(numPeaks);
+	}
+
+	template <typename IndexType>
+	void PeakColumns<IndexType>::clear()
+	{
+		leftTroughX.clear();
+		peakX.clear();
+		rightTroughX.clear();
+		leftTroughY.clear();
+		peakY.clear();
+		rightTroughY.clear();
+		area.clear();
+	}
+
+	template <typename IndexType>
+	const std::vector<double>& PeakColumns<IndexType>::column(Column column) const
+	{
+		switch (column)
+		{
+		case COLUMN_LEFT_TROUGH_Y:
+			return leftTroughY;
+		case COLUMN_PEAK_Y:
+			return peakY;
+		case COLUMN_RIGHT_TROUGH_Y:
+			return rightTroughY;
+		default:
+			break;
+		}
+		return area;
+	}
+
+	// Appends the given rows of the source, in the given order.
+	template <typename IndexType>
+	void PeakColumns<IndexType>::appendRows(const PeakColumns& source, const size_t* rows, size_t numRows)
+	{
+		for (size_t i = 0; i < numRows; ++i)
+		{
+			size_t row = rows[i];
+
+			leftTroughX.push_back(source.leftTroughX[row]);
+			peakX.push_back(source.peakX[row]);
+			rightTroughX.push_back(source.rightTroughX[row]);
+			leftTroughY.push_back(source.leftTroughY[row]);
+			peakY.push_back(source.peakY[row]);
+			rightTroughY.push_back(source.rightTroughY[row]);
+			area.push_back(source.area[row]);
+		}
+	}
+
+	// Sorts row numbers by their values, largest first, keeping ties in row order and putting NaNs last.
+	template <typename IndexType>
+	void PeakColumns<IndexType>::sortRowsDescending(const std::vector<double>& values, std::vector<size_t>& rows) const
+	{
+		std::sort(rows.begin(), rows.end(), [&values](size_t lhs, size_t rhs) {
+			double a = values[lhs];
+			double b = values[rhs];
+
+			if (isnan(a) || isnan(b))
+				return isnan(b) && (!isnan(a) || (lhs < rhs));
+			if (a != b)
+				return a > b;
+			return lhs < rhs;
+		});
+	}
+
+	template <typename IndexType>
+	PeakColumns<IndexType> PeakColumns<IndexType>::filter(Column column, double minValue) const
+	{
+		const size_t BLOCK_SIZE = 1024; // Rows selected at a time, so the selection stays in cache
+		const std::vector<double>& values = this->column(column);
+		size_t rows[BLOCK_SIZE];
+		PeakColumns result;
+
+		for (size_t start = 0; start < values.size(); start += BLOCK_SIZE)
+		{
+			size_t blockLen = std::min(BLOCK_SIZE, values.size() - start);
+			size_t numRows = VectorScan::selectAtOrAbove(values.data() + start, blockLen, minValue, rows);
+
+			for (size_t i = 0; i < numRows; ++i)
+				rows[i] += start;
+			result.appendRows(*this, rows, numRows);
+		}
+		return result;
+	}
+
+	template <typename IndexType>
+	void PeakColumns<IndexType>::sortDescending(Column column)
+	{
+		std::vector<size_t> rows(size());
+		PeakColumns source = *this;
+
+		for (size_t row = 0; row < rows.size(); ++row)
+			rows[row] = row;
+		sortRowsDescending(source.column(column), rows);
+		clear();
+		appendRows(source, rows.data(), rows.size());
+	}
+
+	template <typename IndexType>
+	PeakColumns<IndexType> PeakColumns<IndexType>::topK(Column column, size_t k) const
+	{
+		const std::vector<double>& values = this->column(column);
+		std::vector<double> keys;
+		std::vector<size_t> rows(values.size());
+		size_t numRows;
+		PeakColumns result;
+
+		// Find the k-th largest value, ignoring NaNs, and pick out everything at or above it.
+		keys.reserve(values.size());
+		for (auto iter = values.begin(); iter != values.end(); ++iter)
+		{
+			if (!isnan(*iter))
+				keys.push_back(*iter);
+		}
+
+		if (k == 0)
+		{
+			return result;
+		}
+		else if (k < keys.size())
+		{
+			std::nth_element(keys.begin(), keys.begin() + (k - 1), keys.end(), std::greater<double>());
+			numRows = VectorScan::selectAtOrAbove(values.data(), values.size(), keys[k - 1], rows.data());
+		}
+		else
+		{
+			// Everything is in; NaNs sort to the end.
+			numRows = values.size();
+			for (size_t row = 0; row < numRows; ++row)
+				rows[row] = row;
+		}
+
+		rows.resize(numRows);
+		sortRowsDescending(values, rows);
+		result.reserve(std::min(k, numRows));
+		result.appendRows(*this, rows.data(), std::min(k, numRows));
+		return result;
+	}
+
+	template class PeakColumns<uint32_t>;
+	template class PeakColumns<uint64_t>;
+}
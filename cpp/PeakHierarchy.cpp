@@ -0,0 +1,255 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+
+#include "PeakHierarchy.h"
+
+namespace Peaks
+{
+	// Finds the samples that are higher or lower than the samples on either side of them, taking a flat run of samples
+	// as one, and its middle sample as its position. The first and last runs only need to be higher or lower than the
+	// run next to them. Maxima and minima alternate, and if the data is flat, its middle sample is the only maximum.
+	static void findExtrema(const double* data, size_t dataLen, std::vector<size_t>& extrema)
+	{
+		size_t start = 0; // Start of the current flat run
+		bool hasPrev = false;
+		double prev = (double)0.0;
+
+		for (size_t i = 1; i <= dataLen; ++i)
+		{
+			if (i < dataLen && data[i] == data[start])
+				continue;
+
+			double y = data[start];
+			bool hasNext = (i < dataLen);
+			bool isMax = (!hasPrev || prev < y) && (!hasNext || data[i] < y);
+			bool isMin = (!hasPrev || prev > y) && (!hasNext || data[i] > y);
+
+			if (isMax || isMin)
+				extrema.push_back((start + i - 1) / 2);
+
+			prev = y;
+			hasPrev = true;
+			start = i;
+		}
+	}
+
+	// Union-find root, halving the path on the way.
+	static size_t findIsland(std::vector<size_t>& parents, size_t node)
+	{
+		while (parents[node] != node)
+		{
+			parents[node] = parents[parents[node]];
+			node = parents[node];
+		}
+		return node;
+	}
+
+	PeakHierarchy::PeakHierarchy()
+	{
+		clear();
+	}
+
+	PeakHierarchy::PeakHierarchy(const double* data, size_t dataLen)
+	{
+		build(data, dataLen);
+	}
+
+	void PeakHierarchy::clear()
+	{
+		m_data = NULL;
+		m_dataLen = 0;
+		m_nodes.clear();
+		m_root = NO_PARENT;
+	}
+
+	void PeakHierarchy::build(const double* data, size_t dataLen)
+	{
+		clear();
+
+		m_data = data;
+		m_dataLen = dataLen;
+		if (dataLen == 0)
+			return;
+
+		std::vector<size_t> extrema;
+		findExtrema(data, dataLen, extrema);
+
+		size_t numExtrema = extrema.size();
+		size_t firstMax = (numExtrema > 1 && data[extrema[0]] < data[extrema[1]]) ? 1 : 0;
+		size_t numNodes = (numExtrema - firstMax + 1) / 2;
+
+		// The area prefix at each extremum and at both ends, where the troughs can be.
+		std::vector<AreaPrefix> prefixes(numExtrema);
+		AreaPrefix prefix;
+		size_t i = 0;
+		for (size_t e = 0; e < numExtrema; ++e)
+		{
+			for (; i < extrema[e]; ++i)
+				prefix.advance(i + 1, data[i], data[i + 1]);
+			prefixes[e] = prefix;
+		}
+		for (; i + 1 < dataLen; ++i)
+			prefix.advance(i + 1, data[i], data[i + 1]);
+		AreaPrefix firstPrefix;
+		AreaPrefix lastPrefix = prefix;
+
+		// Every maximum starts as an island of its own, spanning only itself.
+		std::vector<size_t> parents(numNodes);
+		std::vector<size_t> firstNode(numNodes); // Leftmost node of each island
+		std::vector<size_t> lastNode(numNodes);  // Rightmost node of each island
+		std::vector<double> heights(numNodes);   // Height of each node's peak
+
+		m_nodes.resize(numNodes);
+		for (size_t n = 0; n < numNodes; ++n)
+		{
+			m_nodes[n].peak = extrema[firstMax + 2 * n];
+			m_nodes[n].parent = NO_PARENT;
+			heights[n] = data[m_nodes[n].peak];
+			parents[n] = n;
+			firstNode[n] = n;
+			lastNode[n] = n;
+		}
+
+		// Sets a node's troughs from the extent of its island.
+		auto setTroughs = [&](size_t n) {
+			Node& node = m_nodes[n];
+			size_t left = firstMax + 2 * firstNode[n];  // Extremum of the island's first peak
+			size_t right = firstMax + 2 * lastNode[n];  // and of its last
+			const AreaPrefix& leftPrefix = (left > 0) ? prefixes[left - 1] : firstPrefix;
+			const AreaPrefix& rightPrefix = (right + 1 < numExtrema) ? prefixes[right + 1] : lastPrefix;
+
+			node.leftTrough = (left > 0) ? extrema[left - 1] : 0;
+			node.rightTrough = (right + 1 < numExtrema) ? extrema[right + 1] : (dataLen - 1);
+			node.area = leftPrefix.areaTo(rightPrefix);
+		};
+
+		// The minima between two maxima, highest first, ties in order along the x axis.
+		std::vector<std::pair<double, size_t>> saddles;
+		for (size_t e = firstMax + 1; e + 1 < numExtrema; e += 2)
+			saddles.push_back(std::make_pair(-data[extrema[e]], e));
+		std::sort(saddles.begin(), saddles.end());
+
+		// As the water line reaches each saddle, the islands on either side join, and the one with the lower peak
+		// disappears. If the peaks are the same height, the one on the left survives.
+		for (auto iter = saddles.begin(); iter != saddles.end(); ++iter)
+		{
+			size_t saddle = (*iter).second;
+			size_t leftIsland = findIsland(parents, (saddle - 1 - firstMax) / 2);
+			size_t rightIsland = findIsland(parents, (saddle + 1 - firstMax) / 2);
+			bool leftSurvives = heights[leftIsland] >= heights[rightIsland];
+			size_t survivor = leftSurvives ? leftIsland : rightIsland;
+			size_t lost = leftSurvives ? rightIsland : leftIsland;
+
+			m_nodes[lost].persistence = heights[lost] - data[extrema[saddle]];
+			m_nodes[lost].parent = survivor;
+			setTroughs(lost);
+
+			parents[lost] = survivor;
+			firstNode[survivor] = firstNode[leftIsland];
+			lastNode[survivor] = lastNode[rightIsland];
+		}
+
+		// The island that is left has the highest peak, which is measured from the lowest sample.
+		m_root = findIsland(parents, 0);
+
+		double lowest = data[extrema[0]];
+		for (size_t e = 1; e < numExtrema; ++e)
+			lowest = std::min(lowest, data[extrema[e]]);
+
+		m_nodes[m_root].persistence = heights[m_root] - lowest;
+		setTroughs(m_root);
+	}
+
+	GraphPeak PeakHierarchy::graphPeak(size_t index) const
+	{
+		const Node& node = m_nodes[index];
+
+		GraphPeak peak;
+		peak.leftTrough = GraphPoint(node.leftTrough, m_data[node.leftTrough]);
+		peak.peak = GraphPoint(node.peak, m_data[node.peak]);
+		peak.rightTrough = GraphPoint(node.rightTrough, m_data[node.rightTrough]);
+		peak.area = node.area;
+		return peak;
+	}
+
+	// Returns the K most persistent peaks, most persistent first.
+	GraphPeakList PeakHierarchy::topByPersistence(size_t k) const
+	{
+		return top(k, [](const Node& node) { return node.persistence; });
+	}
+
+	// Returns the K peaks with the largest areas, largest first.
+	GraphPeakList PeakHierarchy::topByArea(size_t k) const
+	{
+		return top(k, [](const Node& node) { return node.area; });
+	}
+
+	// Returns the peaks with at least the given persistence, in order along the x axis.
+	GraphPeakList PeakHierarchy::peaksOverPersistence(double minPersistence) const
+	{
+		GraphPeakList peaks;
+
+		for (size_t n = 0; n < m_nodes.size(); ++n)
+		{
+			if (m_nodes[n].persistence >= minPersistence)
+				peaks.push_back(graphPeak(n));
+		}
+		return peaks;
+	}
+
+	// Selects the K nodes with the largest keys with a heap of the best K so far, which has the worst of them on top,
+	// so each node costs O(log K) at most, and only the K nodes are sorted.
+	template <typename Key>
+	GraphPeakList PeakHierarchy::top(size_t k, Key key) const
+	{
+		typedef std::pair<double, size_t> Entry; // Key and node
+		auto better = [](const Entry& a, const Entry& b) { return (a.first > b.first) || ((a.first == b.first) && (a.second < b.second)); };
+
+		std::vector<Entry> heap;
+		heap.reserve(std::min(k, m_nodes.size()));
+
+		for (size_t n = 0; n < m_nodes.size() && k > 0; ++n)
+		{
+			Entry entry(key(m_nodes[n]), n);
+
+			if (heap.size() < k)
+			{
+				heap.push_back(entry);
+				std::push_heap(heap.begin(), heap.end(), better);
+			}
+			else if (better(entry, heap.front()))
+			{
+				std::pop_heap(heap.begin(), heap.end(), better);
+				heap.back() = entry;
+				std::push_heap(heap.begin(), heap.end(), better);
+			}
+		}
+		std::sort_heap(heap.begin(), heap.end(), better);
+
+		GraphPeakList peaks;
+		peaks.reserve(heap.size());
+		for (auto iter = heap.begin(); iter != heap.end(); ++iter)
+			peaks.push_back(graphPeak((*iter).second));
+		return peaks;
+	}
+}
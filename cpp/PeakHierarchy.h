@@ -0,0 +1,106 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#ifndef _PEAKHIERARCHY_
+#define _PEAKHIERARCHY_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "Peaks.h"
+
+namespace Peaks
+{
+	/**
+	 * The peaks of a signal ordered by significance, from the 0-dimensional persistence of its superlevel sets: lowering
+	 * a water line from the top of the signal, each peak appears as an island when the line reaches it and disappears
+	 * when the line reaches the saddle where its island joins one with a higher peak. The height between the two is the
+	 * peak's persistence, and the higher peak is its parent. The highest peak never joins another, so its persistence
+	 * is its height above the lowest sample.
+	 *
+	 * Building the hierarchy takes one pass to reduce the signal to its alternating maxima and minima (the middle sample
+	 * standing for a flat top or bottom), and one union-find pass over the minima in order of height. The K most
+	 * persistent peaks, or the K with the largest areas, then come out of a bounded heap in O(m log K) for m peaks,
+	 * without building or sorting the full list.
+	 *
+	 * The troughs of a peak are the minima on either side of its island when it disappears, one of which is the saddle,
+	 * or the sample at the end of the data on a side that has no minimum. The samples aren't
+	 * copied, so they must outlive the hierarchy, and mustn't contain NaNs.
+	 */
+	class PeakHierarchy
+	{
+	public:
+		static const size_t NO_PARENT = (size_t)-1;
+
+		/**
+		 * A peak in the hierarchy. Positions are sample indexes.
+		 */
+		struct Node
+		{
+			size_t peak;
+			size_t leftTrough;
+			size_t rightTrough;
+			double persistence;
+			double area;
+			size_t parent; // The node this one's island joins, or NO_PARENT for the highest peak
+		};
+
+		PeakHierarchy();
+		PeakHierarchy(const double* data, size_t dataLen);
+
+		void build(const double* data, size_t dataLen);
+		void clear();
+
+		/**
+		 * Peaks in order along the x axis.
+		 */
+		size_t size() const { return m_nodes.size(); }
+		const Node& node(size_t index) const { return m_nodes[index]; }
+		size_t root() const { return m_root; }
+
+		GraphPeak graphPeak(size_t index) const;
+
+		/**
+		 * The K peaks with the highest persistence, or the largest area, in that order. Ties go to the earlier peak.
+		 */
+		GraphPeakList topByPersistence(size_t k) const;
+		GraphPeakList topByArea(size_t k) const;
+
+		/**
+		 * Every peak with at least the given persistence, in order along the x axis.
+		 */
+		GraphPeakList peaksOverPersistence(double minPersistence) const;
+
+	private:
+		const double* m_data;
+		size_t m_dataLen;
+		std::vector<Node> m_nodes;
+		size_t m_root;
+
+		template <typename Key>
+		GraphPeakList top(size_t k, Key key) const;
+	};
+}
+
+#endif
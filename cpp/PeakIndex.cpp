@@ -0,0 +1,433 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "PeakIndex.h"
+#include "Statistics.h"
+#include "VectorScan.h"
+
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+namespace Peaks
+{
+	// Returns the first leaf at or after the given one whose value satisfies the predicate, or the number of leaves if none does.
+	template <typename Predicate>
+	static size_t findFirstLeaf(const std::vector<double>& tree, size_t numLeaves, size_t leaf, Predicate predicate)
+	{
+		size_t pos = leaf + numLeaves;
+
+		// Climb until a subtree to the right of the starting leaf has a match.
+		while (!predicate(tree[pos]))
+		{
+			while (pos & 1)
+				pos >>= 1;
+			if (pos == 0)
+				return numLeaves;
+			++pos;
+		}
+
+		// Then descend to its leftmost match.
+		while (pos < numLeaves)
+		{
+			pos <<= 1;
+			if (!predicate(tree[pos]))
+				++pos;
+		}
+		return pos - numLeaves;
+	}
+
+	// Returns the last leaf at or before the given one whose value satisfies the predicate, or the number of leaves if none does.
+	template <typename Predicate>
+	static size_t findLastLeaf(const std::vector<double>& tree, size_t numLeaves, size_t leaf, Predicate predicate)
+	{
+		size_t pos = leaf + numLeaves;
+
+		// Climb until a subtree to the left of the starting leaf has a match.
+		while (!predicate(tree[pos]))
+		{
+			while ((pos & 1) == 0)
+				pos >>= 1;
+			if (pos == 1)
+				return numLeaves;
+			--pos;
+		}
+
+		// Then descend to its rightmost match.
+
+		while (pos < numLeaves)
+		{
+			pos = (pos << 1) + 1;
+			if (!predicate(tree[pos]))
+				--pos;
+		}
+		return pos - numLeaves;
+	}
+
+	// Maximum of the leaves in [from, to).
+	static double rangeMax(const std::vector<double>& tree, size_t numLeaves, size_t from, size_t to)
+	{
+		double result = -std::numeric_limits<double>::infinity();
+
+		for (from += numLeaves, to += numLeaves; from < to; from >>= 1, to >>= 1)
+		{
+			if (from & 1)
+				result = std::max(result, tree[from++]);
+			if (to & 1)
+				result = std::max(result, tree[--to]);
+		}
+		return result;
+	}
+
+	PeakIndex::PeakIndex()
+	{
+		clear();
+	}
+
+	PeakIndex::PeakIndex(const double* data, size_t dataLen)
+	{
+		build(data, dataLen);
+	}
+
+	void PeakIndex::clear()
+	{
+		m_data = NULL;
+		m_dataLen = 0;
+		m_hasNonFinite = false;
+		m_mean = (double)0.0;
+		m_variance = (double)0.0;
+		m_descentEnd.clear();
+		m_prefixOffset.clear();
+		m_prefixBase.clear();
+		m_numBlocks = 0;
+		m_numLeaves = 0;
+		m_maxTree.clear();
+		m_minTree.clear();
+	}
+
+	void PeakIndex::build(const double* data, size_t dataLen)
+	{
+		clear();
+
+		m_data = data;
+		m_dataLen = dataLen;
+		if (dataLen == 0)
+			return;
+
+		// The mean and variance the same way Peaks::findPeaksOverStd computes them.
+		m_mean = VectorStats::average(data, dataLen);
+		m_variance = VectorStats::sumOfSquaredDeviations(data, dataLen, m_mean) / (double)(dataLen - 1);
+
+		// The area prefix at each sample, computed exactly as the scan does.
+		AreaPrefix prefix;
+		m_prefixOffset.resize(dataLen);
+		m_prefixBase.resize((dataLen + AreaPrefix::BLOCK_SIZE - 1) / AreaPrefix::BLOCK_SIZE);
+		for (size_t i = 0; i < dataLen; ++i)
+		{
+			if (i > 0)
+				prefix.advance(i, data[i - 1], data[i]);
+			if (i % AreaPrefix::BLOCK_SIZE == 0)
+				m_prefixBase[i / AreaPrefix::BLOCK_SIZE] = prefix.base;
+			m_prefixOffset[i] = prefix.offset;
+		}
+		m_hasNonFinite = prefix.hasNonFinite(); // Only the scan keeps track of where these are
+
+		// Ends of the descending runs.
+		m_descentEnd.resize(dataLen);
+		m_descentEnd[dataLen - 1] = dataLen;
+		for (size_t i = dataLen - 1; i > 0; --i)
+			m_descentEnd[i - 1] = (data[i] > data[i - 1]) ? i : m_descentEnd[i];
+
+		// Block minimums and maximums, with the unused leaves set so that they never match.
+		m_numBlocks = (dataLen + BLOCK_SIZE - 1) / BLOCK_SIZE;
+		m_numLeaves = 1;
+		while (m_numLeaves < m_numBlocks)
+			m_numLeaves <<= 1;
+		m_maxTree.assign(2 * m_numLeaves, -std::numeric_limits<double>::infinity());
+		m_minTree.assign(2 * m_numLeaves, std::numeric_limits<double>::infinity());
+
+		for (size_t block = 0; block < m_numBlocks; ++block)
+		{
+			size_t start = block * BLOCK_SIZE;
+			size_t end = std::min(start + BLOCK_SIZE, dataLen);
+			double blockMax = data[start];
+			double blockMin = data[start];
+
+			for (size_t i = start; i < end; ++i)
+			{
+				if (!isfinite(data[i]))
+					m_hasNonFinite = true;
+				blockMax = std::max(blockMax, data[i]);
+				blockMin = std::min(blockMin, data[i]);
+			}
+			m_maxTree[m_numLeaves + block] = blockMax;
+			m_minTree[m_numLeaves + block] = blockMin;
+		}
+		for (size_t pos = m_numLeaves - 1; pos > 0; --pos)
+		{
+			m_maxTree[pos] = std::max(m_maxTree[2 * pos], m_maxTree[2 * pos + 1]);
+			m_minTree[pos] = std::min(m_minTree[2 * pos], m_minTree[2 * pos + 1]);
+		}
+	}
+
+	// Returns a list of peaks in the indexed samples. Only peaks that go above the given threshold will be counted.
+	GraphPeakList PeakIndex::findPeaksOverThreshold(double threshold) const
+	{
+		GraphPeakList peaks;
+		findPeaksOverThreshold(threshold, peaks);
+		return peaks;
+	}
+
+	// Returns a list of peaks in the indexed samples. Only peaks that go above the given sigma line will be counted.
+	GraphPeakList PeakIndex::findPeaksOverStd(double sigmas) const
+	{
+		GraphPeakList peaks;
+		findPeaksOverThreshold(thresholdOverStd(sigmas), peaks);
+		return peaks;
+	}
+
+	size_t PeakIndex::findPeaksOverStd(double sigmas, GraphPeakList& peaks) const
+	{
+		return findPeaksOverThreshold(thresholdOverStd(sigmas), peaks);
+	}
+
+	size_t PeakIndex::findPeaksOverThreshold(double threshold, GraphPeakList& peaks) const
+	{
+		ProfiledCall call;
+
+		if (m_hasNonFinite || isnan(threshold))
+			return Peaks::findPeaksOverThreshold(m_data, m_dataLen, peaks, threshold);
+
+		PeakStats* stats = PeakProfiler::current();
+
+		peaks.clear();
+		if (stats)
+		{
+			Profiling profiler(*stats);
+			scan(threshold, peaks, profiler);
+		}
+		else
+		{
+			NoProfiling profiler;
+			scan(threshold, peaks, profiler);
+		}
+		return peaks.size();
+	}
+
+	double PeakIndex::thresholdOverStd(double sigmas) const
+	{
+		double stddev = sigmas * sqrt(m_variance);
+		return m_mean + stddev;
+	}
+
+	// The threshold state machine of ThresholdScanner, taken a run at a time. Once a left trough is set, the machine is in
+	// one of three states, and in each of them the samples up to the next change only move a trough or the peak:
+	// - Left trough only: the trough moves to each sample below the threshold, so it ends up at the last of them, and
+	//   the first sample at or above the threshold becomes the peak.
+	// - Peak: the peak moves to each sample that is at least as high, so it ends up at the last highest sample of the run
+	//   above the threshold, and the first sample below the threshold becomes the right trough.
+	// - Right trough: the trough follows the samples down to the end of the descending run. A rise that stays below the
+	//   threshold completes the peak; a rise above it extends the peak, and the run above is handled as in the previous
+	//   state, except that the first sample below it only moves the right trough if it is no higher.
+	// An x value of zero means unset, so the first sample never acts as a left trough.
+	template <typename Profiler>
+	void PeakIndex::scan(double threshold, GraphPeakList& peaks, Profiler& profiler) const
+	{
+		const double* data = m_data;
+		size_t i = 1;
+		uint64_t start = profiler.startPhase();
+
+		while (i < m_dataLen)
+		{
+			// Nothing is set, so this sample becomes the left trough whatever its value.
+			size_t left = i;
+			profiler.transition();
+
+			// Left trough only.
+			size_t above = firstAtOrAbove(i + 1, threshold);
+			if (above >= m_dataLen)
+				break;
+			if (above > i + 1)
+			{
+				left = above - 1;
+				profiler.transition();
+			}
+
+			// Peak.
+			size_t below = firstBelow(above + 1, threshold);
+			size_t peak = lastMax(above, below);
+			profiler.transition();
+			if (below >= m_dataLen)
+				break;
+
+			// Right trough.
+			size_t right = below;
+			bool complete = false;
+			profiler.transition();
+
+			while (!complete)
+			{
+				right = m_descentEnd[right] - 1;
+				i = right + 1;
+				if (i >= m_dataLen)
+					break;
+
+				if (data[i] < threshold)
+				{
+					complete = true;
+				}
+				else
+				{
+					below = firstBelow(i + 1, threshold);
+
+					size_t highest = lastMax(i, below);
+					if (data[highest] >= data[peak])
+						peak = highest;
+					profiler.transition();
+
+					i = below;
+					if (i >= m_dataLen)
+						break;
+					if (data[i] <= data[right])
+						right = i;
+					else
+						complete = true;
+				}
+				profiler.transition();
+			}
+			if (!complete)
+				break;
+
+			GraphPeak found;
+			found.leftTrough = GraphPoint(left, data[left]);
+			found.peak = GraphPoint(peak, data[peak]);
+			found.rightTrough = GraphPoint(right, data[right]);
+			found.area = prefixAt(left).areaTo(prefixAt(right));
+			profiler.append(peaks, found);
+
+			// The sample that completed the peak isn't used again.
+			i = i + 1;
+		}
+		profiler.endPhase(PeakStats::PHASE_SCAN, start);
+	}
+
+	AreaPrefix PeakIndex::prefixAt(size_t index) const
+	{
+		AreaPrefix prefix;
+		prefix.base = m_prefixBase[index / AreaPrefix::BLOCK_SIZE];
+		prefix.offset = m_prefixOffset[index];
+		return prefix;
+	}
+
+	// Index of the first sample at or after from that is not below the threshold, or the number of samples.
+	size_t PeakIndex::firstAtOrAbove(size_t from, double threshold) const
+	{
+		if (from >= m_dataLen)
+			return m_dataLen;
+
+		size_t blockEnd = std::min((from / BLOCK_SIZE + 1) * BLOCK_SIZE, m_dataLen);
+		size_t found = VectorScan::findFirstAtOrAbove(m_data, from, blockEnd, threshold);
+		if (found < blockEnd || blockEnd == m_dataLen)
+			return found;
+
+		size_t block = findFirstLeaf(m_maxTree, m_numLeaves, blockEnd / BLOCK_SIZE, [threshold](double value) { return value >= threshold; });
+		if (block >= m_numBlocks)
+			return m_dataLen;
+
+		size_t start = block * BLOCK_SIZE;
+		return VectorScan::findFirstAtOrAbove(m_data, start, std::min(start + BLOCK_SIZE, m_dataLen), threshold);
+	}
+
+	// Index of the first sample at or after from that is below the threshold, or the number of samples.
+	size_t PeakIndex::firstBelow(size_t from, double threshold) const
+	{
+		if (from >= m_dataLen)
+			return m_dataLen;
+
+		size_t blockEnd = std::min((from / BLOCK_SIZE + 1) * BLOCK_SIZE, m_dataLen);
+		for (; from < blockEnd; ++from)
+		{
+			if (m_data[from] < threshold)
+				return from;
+		}
+		if (blockEnd == m_dataLen)
+			return m_dataLen;
+
+		size_t block = findFirstLeaf(m_minTree, m_numLeaves, blockEnd / BLOCK_SIZE, [threshold](double value) { return value < threshold; });
+		if (block >= m_numBlocks)
+			return m_dataLen;
+
+		for (from = block * BLOCK_SIZE; m_data[from] >= threshold; ++from) {}
+		return from;
+	}
+
+	// Index of the last of the highest samples in [from, to), which mustn't be empty.
+	size_t PeakIndex::lastMax(size_t from, size_t to) const
+	{
+		size_t firstBlock = (from + BLOCK_SIZE - 1) / BLOCK_SIZE; // First whole block
+		size_t lastBlock = to / BLOCK_SIZE;                        // One past the last whole block
+
+		// Short ranges, and the partial blocks at either end, one sample at a time.
+		if (firstBlock >= lastBlock)
+		{
+			size_t highest = from;
+			for (size_t i = from + 1; i < to; ++i)
+			{
+				if (m_data[i] >= m_data[highest])
+					highest = i;
+			}
+			return highest;
+		}
+
+		size_t highest = to;
+		double highestValue = -std::numeric_limits<double>::infinity();
+		for (size_t i = from; i < firstBlock * BLOCK_SIZE; ++i)
+		{
+			if (highest == to || m_data[i] >= highestValue)
+			{
+				highest = i;
+				highestValue = m_data[i];
+			}
+		}
+
+		double blocksMax = rangeMax(m_maxTree, m_numLeaves, firstBlock, lastBlock);
+		if (highest == to || blocksMax >= highestValue)
+		{
+			size_t block = findLastLeaf(m_maxTree, m_numLeaves, lastBlock - 1, [blocksMax](double value) { return value >= blocksMax; });
+			size_t i = std::min((block + 1) * BLOCK_SIZE, m_dataLen);
+
+			while (m_data[--i] < blocksMax) {}
+			highest = i;
+			highestValue = blocksMax;
+		}
+
+		for (size_t i = lastBlock * BLOCK_SIZE; i < to; ++i)
+		{
+			if (m_data[i] >= highestValue)
+			{
+				highest = i;
+				highestValue = m_data[i];
+			}
+		}
+		return highest;
+	}
+}
@@ -0,0 +1,106 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#ifndef _PEAKINDEX_
+#define _PEAKINDEX_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "Peaks.h"
+
+namespace Peaks
+{
+	/**
+	 * Index over an array of samples for running many threshold queries against the same data, e.g. to sweep thresholds
+	 * while tuning sensitivity. Building it takes one pass. Each query then jumps from one change of state to the next
+	 * instead of reading every sample, so it costs about O(log n) per peak rather than O(n), and returns exactly what
+	 * Peaks::findPeaksOverThreshold and Peaks::findPeaksOverStd would.
+	 *
+	 * The index holds:
+	 * - the minimum and maximum of each block of samples, in segment trees, for finding the next sample on the other
+	 *   side of the threshold and the highest sample in a run;
+	 * - the end of the descending run that starts at each sample, which doesn't depend on the threshold and is where a
+	 *   right trough stops moving;
+	 * - the area prefix at each sample, so areas are differences of two prefixes as in the scan;
+	 * - the mean and variance, for the sigma queries, computed with the VectorStats instruction set in use at the time.
+	 *
+	 * The samples aren't copied, so they must outlive the index. Arrays that contain NaNs or infinities (or whose areas
+	 * overflow), and NaN thresholds, are answered with a regular scan. Queries don't modify the index and can be made
+	 * from several threads at once.
+	 */
+	class PeakIndex
+	{
+	public:
+		PeakIndex();
+		PeakIndex(const double* data, size_t dataLen);
+
+		void build(const double* data, size_t dataLen);
+		void clear();
+
+		GraphPeakList findPeaksOverThreshold(double threshold) const;
+		GraphPeakList findPeaksOverStd(double sigmas) const;
+
+		/**
+		 * Same as above, but the peaks replace the contents of the given list. Returns the number of peaks found.
+		 */
+		size_t findPeaksOverThreshold(double threshold, GraphPeakList& peaks) const;
+		size_t findPeaksOverStd(double sigmas, GraphPeakList& peaks) const;
+
+		size_t size() const { return m_dataLen; }
+		double mean() const { return m_mean; }
+		double variance() const { return m_variance; }
+
+	private:
+		static const size_t BLOCK_SIZE = 64; // Samples per leaf of the segment trees
+
+		const double* m_data;
+		size_t m_dataLen;
+		bool m_hasNonFinite;
+		double m_mean;
+		double m_variance;
+
+		std::vector<size_t> m_descentEnd;   // First sample after each one that rises above the one before it
+		std::vector<double> m_prefixOffset; // AreaPrefix::offset at each sample
+		std::vector<double> m_prefixBase;   // AreaPrefix::base for each block of AreaPrefix::BLOCK_SIZE samples
+
+		size_t m_numBlocks;
+		size_t m_numLeaves; // Number of blocks rounded up to a power of two
+		std::vector<double> m_maxTree;
+		std::vector<double> m_minTree;
+
+		double thresholdOverStd(double sigmas) const;
+
+		template <typename Profiler>
+		void scan(double threshold, GraphPeakList& peaks, Profiler& profiler) const;
+
+		AreaPrefix prefixAt(size_t index) const;
+		size_t firstAtOrAbove(size_t from, double threshold) const;
+		size_t firstBelow(size_t from, double threshold) const;
+		size_t lastMax(size_t from, size_t to) const;
+	};
+}
+
+#endif
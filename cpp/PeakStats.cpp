@@ -0,0 +1,99 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "PeakStats.h"
+
+#include <chrono>
+
+namespace Peaks
+{
+	void PeakStats::clear()
+	{
+		numCalls = 0;
+		samplesScanned = 0;
+		stateTransitions = 0;
+		peaksEmitted = 0;
+		bytesAllocated = 0;
+		for (size_t phase = 0; phase < NUM_PHASES; ++phase)
+			phaseNanoseconds[phase] = 0;
+		allocationNanoseconds = 0;
+		totalNanoseconds = 0;
+	}
+
+	PeakStats& PeakStats::operator+=(const PeakStats& rhs)
+	{
+		numCalls += rhs.numCalls;
+		samplesScanned += rhs.samplesScanned;
+		stateTransitions += rhs.stateTransitions;
+		peaksEmitted += rhs.peaksEmitted;
+		bytesAllocated += rhs.bytesAllocated;
+		for (size_t phase = 0; phase < NUM_PHASES; ++phase)
+			phaseNanoseconds[phase] += rhs.phaseNanoseconds[phase];
+		allocationNanoseconds += rhs.allocationNanoseconds;
+		totalNanoseconds += rhs.totalNanoseconds;
+		return *this;
+	}
+
+	const char* PeakStats::phaseName(Phase phase)
+	{
+		switch (phase)
+		{
+		case PHASE_STATS:
+			return "stats";
+		case PHASE_AREA:
+			return "area";
+		case PHASE_SCAN:
+			return "scan";
+		default:
+			break;
+		}
+		return "unknown";
+	}
+
+#ifndef PEAKS_NO_PROFILING
+	thread_local PeakStats* PeakProfiler::s_current = NULL;
+	thread_local size_t PeakProfiler::s_callDepth = 0;
+#endif
+
+	PeakProfiler::PeakProfiler(PeakStats* stats)
+	{
+#ifdef PEAKS_NO_PROFILING
+		(void)stats;
+		m_previous = NULL;
+#else
+		m_previous = s_current;
+		s_current = stats;
+#endif
+	}
+
+	PeakProfiler::~PeakProfiler()
+	{
+#ifndef PEAKS_NO_PROFILING
+		s_current = m_previous;
+#endif
+	}
+
+	uint64_t PeakProfiler::now()
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+}
@@ -0,0 +1,144 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#ifndef _PEAKSTATS_
+#define _PEAKSTATS_
+
+#include <stdint.h>
+#include <stdlib.h>
+
+namespace Peaks
+{
+	/**
+	 * Counters for calls to the peak finders, collected with a PeakProfiler. The times are wall clock nanoseconds, except
+	 * that the multi-threaded functions add up the time each thread spends in a phase, so their phase times can add up to
+	 * more than the total. State transitions are the trough and peak events of the threshold state machine; a run of
+	 * samples that only moves a trough counts once.
+	 */
+	struct PeakStats
+	{
+		typedef enum Phase
+		{
+			PHASE_STATS = 0, // Mean and standard deviation for the threshold
+			PHASE_AREA,      // Separate passes over the area (the serial scans keep the area as they go)
+			PHASE_SCAN,      // The threshold state machine, less the time spent growing the results
+			NUM_PHASES
+		} Phase;
+
+		uint64_t numCalls;
+		uint64_t samplesScanned;
+		uint64_t stateTransitions;
+		uint64_t peaksEmitted;
+		uint64_t bytesAllocated;        // For the results
+		uint64_t phaseNanoseconds[NUM_PHASES];
+		uint64_t allocationNanoseconds; // Growing the results
+		uint64_t totalNanoseconds;
+
+		PeakStats() { clear(); }
+
+		void clear();
+		PeakStats& operator+=(const PeakStats& rhs);
+
+		static const char* phaseName(Phase phase);
+	};
+
+	/**
+	 * Collects PeakStats for the peak finder calls made on the current thread while it exists, adding to whatever the
+	 * stats already hold. Profilers can be nested; the innermost one collects. Building with PEAKS_NO_PROFILING
+	 * removes the instrumentation, and the stats then stay empty.
+	 */
+	class PeakProfiler
+	{
+	public:
+		PeakProfiler(PeakStats* stats);
+		~PeakProfiler();
+
+		/**
+		 * The stats being collected on this thread, or NULL.
+		 */
+#ifdef PEAKS_NO_PROFILING
+		static PeakStats* current() { return NULL; }
+#else
+		static PeakStats* current() { return s_current; }
+#endif
+
+		static uint64_t now(); // Steady clock, in nanoseconds
+
+	private:
+		PeakProfiler(const PeakProfiler&);
+		PeakProfiler& operator=(const PeakProfiler&);
+
+		PeakStats* m_previous;
+
+#ifndef PEAKS_NO_PROFILING
+		static thread_local PeakStats* s_current;
+		static thread_local size_t s_callDepth;
+
+		friend class ProfiledCall;
+#endif
+	};
+
+	/**
+	 * Placed at the top of each peak finder to count the call and time it. Calls made by another peak finder aren't
+	 * counted separately.
+	 */
+	class ProfiledCall
+	{
+	public:
+#ifdef PEAKS_NO_PROFILING
+		ProfiledCall() {}
+#else
+		ProfiledCall() : m_stats(NULL), m_start(0), m_entered(false)
+		{
+			if (PeakProfiler::s_current)
+			{
+				m_entered = true;
+				if (PeakProfiler::s_callDepth++ == 0)
+				{
+					m_stats = PeakProfiler::s_current;
+					m_start = PeakProfiler::now();
+				}
+			}
+		}
+
+		~ProfiledCall()
+		{
+			if (m_stats)
+			{
+				m_stats->totalNanoseconds += PeakProfiler::now() - m_start;
+				++m_stats->numCalls;
+			}
+			if (m_entered)
+				--PeakProfiler::s_callDepth;
+		}
+
+	private:
+		PeakStats* m_stats;
+		uint64_t m_start;
+		bool m_entered;
+#endif
+	};
+}
+
+#endif
@@ -0,0 +1,187 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "PeakTracker.h"
+
+#include <algorithm>
+
+namespace Peaks
+{
+	static uint64_t distance(uint64_t lhs, uint64_t rhs)
+	{
+		return (lhs > rhs) ? (lhs - rhs) : (rhs - lhs);
+	}
+
+	static bool trackBefore(const PeakTracker::Track& lhs, const PeakTracker::Track& rhs)
+	{
+		return lhs.lastPeak.peak.x < rhs.lastPeak.peak.x;
+	}
+
+	PeakTracker::PeakTracker(uint64_t maxDistance, size_t maxMissedFrames, TrackCallback callback) :
+		m_maxDistance(maxDistance),
+		m_maxMissedFrames(maxMissedFrames),
+		m_callback(callback),
+		m_frame(0),
+		m_nextId(0)
+	{
+	}
+
+	void PeakTracker::clear()
+	{
+		m_tracks.clear();
+		m_nextTracks.clear();
+		m_frameTrackIds.clear();
+		m_frame = 0;
+	}
+
+	void PeakTracker::finish()
+	{
+		if (m_callback)
+		{
+			for (auto iter = m_tracks.begin(); iter != m_tracks.end(); ++iter)
+				m_callback(TRACK_DEATH, (*iter));
+		}
+		m_tracks.clear();
+	}
+
+	size_t PeakTracker::update(const GraphPeakList& peaks)
+	{
+		return update(peaks.data(), peaks.size());
+	}
+
+	// Merges the frame's peaks, in order of position, with the live tracks, which are kept in order of position.
+	size_t PeakTracker::update(const GraphPeak* peaks, size_t numPeaks)
+	{
+		m_order.resize(numPeaks);
+		for (size_t i = 0; i < numPeaks; ++i)
+			m_order[i] = i;
+
+		auto peakBefore = [peaks](size_t lhs, size_t rhs) { return peaks[lhs].peak.x < peaks[rhs].peak.x; };
+		if (!std::is_sorted(m_order.begin(), m_order.end(), peakBefore))
+			std::stable_sort(m_order.begin(), m_order.end(), peakBefore);
+
+		m_frameTrackIds.resize(numPeaks);
+		m_nextTracks.clear();
+
+		size_t numTracks = m_tracks.size();
+		size_t i = 0;
+		size_t j = 0;
+
+		while ((i < numPeaks) || (j < numTracks))
+		{
+			if (i == numPeaks)
+			{
+				missTrack(m_tracks[j++]);
+				continue;
+			}
+			if (j == numTracks)
+			{
+				startTrack(peaks[m_order[i]], m_order[i]);
+				++i;
+				continue;
+			}
+
+			const GraphPeak& peak = peaks[m_order[i]];
+			uint64_t peakX = peak.peak.x;
+			uint64_t trackX = m_tracks[j].lastPeak.peak.x;
+			uint64_t gap = distance(peakX, trackX);
+
+			if (gap > m_maxDistance)
+			{
+				if (peakX < trackX)
+				{
+					startTrack(peak, m_order[i]);
+					++i;
+				}
+				else
+				{
+					missTrack(m_tracks[j++]);
+				}
+			}
+
+			// In range, but leave the pair for a nearer neighbor on either side.
+			else if ((j + 1 < numTracks) && (distance(peakX, m_tracks[j + 1].lastPeak.peak.x) < gap))
+			{
+				missTrack(m_tracks[j++]);
+			}
+			else if ((i + 1 < numPeaks) && (distance(peaks[m_order[i + 1]].peak.x, trackX) < gap))
+			{
+				startTrack(peak, m_order[i]);
+				++i;
+			}
+			else
+			{
+				continueTrack(m_tracks[j++], peak, m_order[i]);
+				++i;
+			}
+		}
+
+		// The merge keeps the order, except where positions are repeated.
+		if (!std::is_sorted(m_nextTracks.begin(), m_nextTracks.end(), trackBefore))
+			std::stable_sort(m_nextTracks.begin(), m_nextTracks.end(), trackBefore);
+
+		m_tracks.swap(m_nextTracks);
+		++m_frame;
+		return m_tracks.size();
+	}
+
+	void PeakTracker::startTrack(const GraphPeak& peak, size_t index)
+	{
+		Track track;
+
+		track.id = m_nextId++;
+		track.firstFrame = m_frame;
+		track.lastFrame = m_frame;
+		track.numMissed = 0;
+		track.lastPeak = peak;
+		track.firstPoint = peak.peak;
+		track.heights.push(peak.peak.y);
+		track.totalArea = peak.area;
+
+		m_nextTracks.push_back(track);
+		m_frameTrackIds[index] = track.id;
+
+		if (m_callback)
+			m_callback(TRACK_BIRTH, m_nextTracks.back());
+	}
+
+	void PeakTracker::continueTrack(Track& track, const GraphPeak& peak, size_t index)
+	{
+		track.lastFrame = m_frame;
+		track.numMissed = 0;
+		track.lastPeak = peak;
+		track.heights.push(peak.peak.y);
+		track.totalArea += peak.area;
+
+		m_nextTracks.push_back(track);
+		m_frameTrackIds[index] = track.id;
+	}
+
+	void PeakTracker::missTrack(Track& track)
+	{
+		++track.numMissed;
+
+		if (track.numMissed <= m_maxMissedFrames)
+			m_nextTracks.push_back(track);
+		else if (m_callback)
+			m_callback(TRACK_DEATH, track);
+	}
+}
@@ -0,0 +1,129 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#ifndef _PEAKTRACKER_
+#define _PEAKTRACKER_
+
+#include <functional>
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "Peaks.h"
+#include "Statistics.h"
+
+namespace Peaks
+{
+	/**
+	 * Links the peaks found in consecutive frames (e.g., the rows of a spectrogram, or successive windows of a signal)
+	 * into tracks with stable IDs. Each frame's peaks are matched to the live tracks by the x position of the peak:
+	 * both are walked in order of position, and a peak continues the track it is nearest to, provided they are within
+	 * maxDistance and neither has a nearer neighbor in the other list. Matches never cross, so each frame takes
+	 * O(peaks + tracks), plus a sort if the frame's peaks aren't already in order along the x axis (the threshold
+	 * finders return them in order). Nothing is allocated once the lists have grown to the largest frame.
+	 *
+	 * A peak that doesn't continue a track starts a new one. A track that isn't continued is kept at its last position
+	 * for up to maxMissedFrames frames, so a peak that drops out for a frame keeps its ID, and then ends.
+	 */
+	class PeakTracker
+	{
+	public:
+		typedef enum TrackEvent
+		{
+			TRACK_BIRTH = 0,
+			TRACK_DEATH
+		} TrackEvent;
+
+		/**
+		 * A track. Frames are counted from zero.
+		 */
+		struct Track
+		{
+			uint64_t id;
+			uint64_t firstFrame;
+			uint64_t lastFrame;    // The last frame with a peak in the track
+			size_t numMissed;      // Frames since then
+			GraphPeak lastPeak;
+			GraphPoint firstPoint; // The top of the first peak
+			RunningStats heights;  // Of the tops of the peaks
+			double totalArea;
+
+			uint64_t numPeaks() const { return heights.count(); }
+		};
+
+		/**
+		 * Called when a track starts, with its first peak, and when it ends, after its last peak and any missed frames.
+		 */
+		typedef std::function<void(TrackEvent event, const Track& track)> TrackCallback;
+
+		PeakTracker(uint64_t maxDistance, size_t maxMissedFrames = 0, TrackCallback callback = TrackCallback());
+
+		/**
+		 * Adds the next frame. Returns the number of live tracks afterwards.
+		 */
+		size_t update(const GraphPeakList& peaks);
+		size_t update(const GraphPeak* peaks, size_t numPeaks);
+
+		/**
+		 * Ends every live track, e.g. at the end of the data.
+		 */
+		void finish();
+
+		/**
+		 * Drops the tracks without reporting their deaths and starts over at frame zero. IDs aren't reused.
+		 */
+		void clear();
+
+		/**
+		 * The live tracks, in order along the x axis.
+		 */
+		const std::vector<Track>& tracks() const { return m_tracks; }
+
+		/**
+		 * The ID of the track each peak of the last frame went to, in the order the peaks were given.
+		 */
+		const std::vector<uint64_t>& frameTrackIds() const { return m_frameTrackIds; }
+
+		void setCallback(TrackCallback callback) { m_callback = callback; }
+
+		uint64_t numFrames() const { return m_frame; }
+		uint64_t numTracksStarted() const { return m_nextId; }
+
+	private:
+		uint64_t m_maxDistance;
+		size_t m_maxMissedFrames;
+		TrackCallback m_callback;
+		std::vector<Track> m_tracks;
+		std::vector<Track> m_nextTracks;  // Built during an update, then swapped with m_tracks
+		std::vector<size_t> m_order;      // The frame's peaks, sorted by position
+		std::vector<uint64_t> m_frameTrackIds;
+		uint64_t m_frame;
+		uint64_t m_nextId;
+
+		void startTrack(const GraphPeak& peak, size_t index);
+		void continueTrack(Track& track, const GraphPeak& peak, size_t index);
+		void missTrack(Track& track);
+	};
+}
+
+#endif
@@ -0,0 +1,326 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "PeakWriter.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__has_include)
+#if __has_include(<charconv>) && (__cplusplus >= 201703L)
+#include <charconv>
+#endif
+#endif
+
+#if defined(__cpp_lib_to_chars) && (__cpp_lib_to_chars >= 201611L)
+#define PEAKS_HAVE_TO_CHARS 1
+#endif
+
+namespace Peaks
+{
+	static const size_t MAX_NUMBER_LEN = 32; // Longest number the writer formats, with room to spare
+
+	PeakWriter::PeakWriter(FILE* file, Format format, size_t bufferSize) :
+		m_file(file),
+		m_format(format),
+		m_buffer(bufferSize < 256 ? 256 : bufferSize),
+		m_used(0),
+		m_inChannel(false),
+		m_failed(false)
+	{
+		if (m_format == FORMAT_CSV)
+			append("channel,left_trough_x,left_trough_y,peak_x,peak_y,right_trough_x,right_trough_y,area\n");
+	}
+
+	PeakWriter::~PeakWriter()
+	{
+		flush();
+	}
+
+	bool PeakWriter::parseFormat(const std::string& name, Format& format)
+	{
+		if (name == "text")
+			format = FORMAT_TEXT;
+		else if (name == "csv")
+			format = FORMAT_CSV;
+		else if (name == "jsonl")
+			format = FORMAT_JSONL;
+		else if (name == "binary")
+			format = FORMAT_BINARY;
+		else
+			return false;
+		return true;
+	}
+
+	bool PeakWriter::flush()
+	{
+		if (m_used > 0)
+		{
+			if (fwrite(m_buffer.data(), 1, m_used, m_file) != m_used)
+				m_failed = true;
+			m_used = 0;
+		}
+		if (fflush(m_file) != 0)
+			m_failed = true;
+		return !m_failed;
+	}
+
+	// Returns room for len more bytes, writing out the buffer first if there isn't enough.
+	char* PeakWriter::reserve(size_t len)
+	{
+		if (m_used + len > m_buffer.size())
+		{
+			if (fwrite(m_buffer.data(), 1, m_used, m_file) != m_used)
+				m_failed = true;
+			m_used = 0;
+
+			if (len > m_buffer.size())
+				m_buffer.resize(len);
+		}
+		return m_buffer.data() + m_used;
+	}
+
+	void PeakWriter::append(const char* str, size_t len)
+	{
+		memcpy(reserve(len), str, len);
+		m_used += len;
+	}
+
+	void PeakWriter::append(const char* str)
+	{
+		append(str, strlen(str));
+	}
+
+	void PeakWriter::appendUInt(uint64_t value)
+	{
+		char* pos = reserve(MAX_NUMBER_LEN);
+
+#ifdef PEAKS_HAVE_TO_CHARS
+		m_used = std::to_chars(pos, pos + MAX_NUMBER_LEN, value).ptr - m_buffer.data();
+#else
+		m_used += snprintf(pos, MAX_NUMBER_LEN, "%llu", (unsigned long long)value);
+#endif
+	}
+
+	// Exact values are the shortest that read back the same. Otherwise there are six significant digits, as with iostreams.
+	void PeakWriter::appendDouble(double value, bool exact)
+	{
+		char* pos = reserve(MAX_NUMBER_LEN);
+
+#ifdef PEAKS_HAVE_TO_CHARS
+		std::to_chars_result result;
+		if (exact)
+			result = std::to_chars(pos, pos + MAX_NUMBER_LEN, value);
+		else
+			result = std::to_chars(pos, pos + MAX_NUMBER_LEN, value, std::chars_format::general, 6);
+		m_used = result.ptr - m_buffer.data();
+#else
+		m_used += snprintf(pos, MAX_NUMBER_LEN, exact ? "%.17g" : "%g", value);
+#endif
+	}
+
+	// JSON has no NaN or infinity, so those are written as null.
+	void PeakWriter::appendJsonPoint(const char* name, const GraphPoint& point)
+	{
+		append(name);
+		append("{\"x\":");
+		appendUInt(point.x);
+		append(",\"y\":");
+		if (isfinite(point.y))
+			appendDouble(point.y, true);
+		else
+			append("null");
+		append("}");
+	}
+
+	// Quotes a string, escaping the characters JSON requires.
+	void PeakWriter::appendJsonString(const std::string& str)
+	{
+		append("\"");
+		for (auto iter = str.begin(); iter != str.end(); ++iter)
+		{
+			char c = (*iter);
+
+			if ((c == '"') || (c == '\\'))
+			{
+				char escaped[2] = { '\\', c };
+				append(escaped, 2);
+			}
+			else if ((unsigned char)c < 0x20)
+			{
+				char escaped[8];
+				snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned)c);
+				append(escaped);
+			}
+			else
+			{
+				append(&c, 1);
+			}
+		}
+		append("\"");
+	}
+
+	void PeakWriter::beginJob(const std::string& id)
+	{
+		m_job = id;
+
+		if (m_format == FORMAT_TEXT)
+		{
+			append("Job ");
+			append(m_job.c_str(), m_job.length());
+			append("\n");
+		}
+	}
+
+	void PeakWriter::endJob(size_t numPeaks, const std::string& error)
+	{
+		switch (m_format)
+		{
+		case FORMAT_TEXT:
+			append("Job ");
+			append(m_job.c_str(), m_job.length());
+			if (error.empty())
+			{
+				append(": ");
+				appendUInt(numPeaks);
+				append(" peaks\n");
+			}
+			else
+			{
+				append(" failed: ");
+				append(error.c_str(), error.length());
+				append("\n");
+			}
+			break;
+		case FORMAT_JSONL:
+			append("{\"job\":");
+			appendJsonString(m_job);
+			if (error.empty())
+			{
+				append(",\"peaks\":");
+				appendUInt(numPeaks);
+			}
+			else
+			{
+				append(",\"error\":");
+				appendJsonString(error);
+			}
+			append("}\n");
+			break;
+		default:
+			break;
+		}
+		m_job.clear();
+	}
+
+	void PeakWriter::beginChannel()
+	{
+		if (m_format == FORMAT_TEXT)
+			append("Axis Peaks\n");
+		m_inChannel = true;
+	}
+
+	void PeakWriter::endChannel()
+	{
+		if (m_format == FORMAT_TEXT)
+			append("\n");
+		m_inChannel = false;
+	}
+
+	void PeakWriter::write(size_t channel, const GraphPeak& peak)
+	{
+		switch (m_format)
+		{
+		case FORMAT_TEXT:
+			if (!m_inChannel)
+			{
+				append("Axis ");
+				appendUInt(channel);
+				append(": ");
+			}
+			append("{ ");
+			appendUInt(peak.leftTrough.x);
+			append(", ");
+			appendUInt(peak.peak.x);
+			append(", ");
+			appendUInt(peak.rightTrough.x);
+			append(", ");
+			appendDouble(peak.area, false);
+			append(" }\n");
+			break;
+		case FORMAT_CSV:
+			appendUInt(channel);
+			append(",");
+			appendUInt(peak.leftTrough.x);
+			append(",");
+			appendDouble(peak.leftTrough.y, true);
+			append(",");
+			appendUInt(peak.peak.x);
+			append(",");
+			appendDouble(peak.peak.y, true);
+			append(",");
+			appendUInt(peak.rightTrough.x);
+			append(",");
+			appendDouble(peak.rightTrough.y, true);
+			append(",");
+			appendDouble(peak.area, true);
+			append("\n");
+			break;
+		case FORMAT_JSONL:
+			append("{");
+			if (!m_job.empty())
+			{
+				append("\"job\":");
+				appendJsonString(m_job);
+				append(",");
+			}
+			append("\"channel\":");
+			appendUInt(channel);
+			appendJsonPoint(",\"left_trough\":", peak.leftTrough);
+			appendJsonPoint(",\"peak\":", peak.peak);
+			appendJsonPoint(",\"right_trough\":", peak.rightTrough);
+			append(",\"area\":");
+			if (isfinite(peak.area))
+				appendDouble(peak.area, true);
+			else
+				append("null");
+			append("}\n");
+			break;
+		case FORMAT_BINARY:
+			{
+				PeakRecord record;
+
+				record.channel = (uint32_t)channel;
+				record.reserved = 0;
+				record.leftTroughX = peak.leftTrough.x;
+				record.leftTroughY = peak.leftTrough.y;
+				record.peakX = peak.peak.x;
+				record.peakY = peak.peak.y;
+				record.rightTroughX = peak.rightTrough.x;
+				record.rightTroughY = peak.rightTrough.y;
+				record.area = peak.area;
+				append(reinterpret_cast<const char*>(&record), sizeof(record));
+			}
+			break;
+		}
+	}
+}
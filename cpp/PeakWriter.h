@@ -0,0 +1,118 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#ifndef _PEAKWRITER_
+#define _PEAKWRITER_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "Peaks.h"
+
+namespace Peaks
+{
+	/**
+	 * Record written for each peak in the binary format, in host byte order. 64 bytes, with no padding.
+	 */
+	struct PeakRecord
+	{
+		uint32_t channel;
+		uint32_t reserved;
+		uint64_t leftTroughX;
+		double leftTroughY;
+		uint64_t peakX;
+		double peakY;
+		uint64_t rightTroughX;
+		double rightTroughY;
+		double area;
+	};
+
+	/**
+	 * Writes peaks to a file through a large buffer, formatting numbers with to_chars where it's available.
+	 *
+	 * TEXT is the human readable { left, peak, right, area } format. Peaks written between beginChannel() and endChannel()
+	 * are grouped under an "Axis Peaks" heading; others are tagged with their channel. The other formats have a record
+	 * per peak with the channel, all three points and the area: CSV (with a header row), JSON Lines, and PeakRecords.
+	 * Values are written with enough digits to be read back exactly, except in the text format.
+	 */
+	class PeakWriter
+	{
+	public:
+		typedef enum Format
+		{
+			FORMAT_TEXT = 0,
+			FORMAT_CSV,
+			FORMAT_JSONL,
+			FORMAT_BINARY
+		} Format;
+
+		PeakWriter(FILE* file, Format format, size_t bufferSize = 1 << 20);
+		~PeakWriter();
+
+		static bool parseFormat(const std::string& name, Format& format); // "text", "csv", "jsonl" or "binary"
+
+		void beginChannel();
+		void endChannel();
+		void write(size_t channel, const GraphPeak& peak);
+
+		/**
+		 * Groups the peaks written in between under a job ID, for the --serve mode. In the text format there is a "Job <id>"
+		 * heading before them and a "Job <id>: <n> peaks" (or "Job <id> failed: <error>") line after them. In JSON Lines each
+		 * record is tagged with the job and there is a closing {"job":...,"peaks":n} (or "error") record. The CSV and binary
+		 * formats have nowhere to put the ID, so they don't support jobs.
+		 */
+		void beginJob(const std::string& id);
+		void endJob(size_t numPeaks, const std::string& error = "");
+		static bool supportsJobs(Format format) { return (format == FORMAT_TEXT) || (format == FORMAT_JSONL); }
+
+		/**
+		 * Writes out everything buffered so far. Returns false if the file has had a write error.
+		 */
+		bool flush();
+
+	private:
+		PeakWriter(const PeakWriter&);
+		PeakWriter& operator=(const PeakWriter&);
+
+		FILE* m_file;
+		Format m_format;
+		std::vector<char> m_buffer;
+		size_t m_used;
+		bool m_inChannel;
+		std::string m_job; // Empty unless between beginJob() and endJob()
+		bool m_failed;
+
+		char* reserve(size_t len);
+		void append(const char* str, size_t len);
+		void append(const char* str);
+		void appendUInt(uint64_t value);
+		void appendDouble(double value, bool exact);
+		void appendJsonPoint(const char* name, const GraphPoint& point);
+		void appendJsonString(const std::string& str);
+	};
+}
+
+#endif
@@ -20,384 +20,588 @@
 // SOFTWARE.
 
 #include "Peaks.h"
+#include "Statistics.h"
+#include "StreamingPeakFinder.h"
+#include "ThreadPool.h"
+#include "VectorScan.h"
 
+#include <algorithm>
 #include <string.h>
 #include <math.h>
 
 namespace Peaks
 {
-	// Computes the area of the given peak.
-	void Peaks::computeArea(double* data, size_t dataLen, GraphPeak& currentPeak)
+	// Compares bit patterns rather than values so that NaN samples compare equal to themselves.
+	static bool samePoint(const GraphPoint& lhs, const GraphPoint& rhs)
 	{
-		currentPeak.area = (double)0.0;
-		
-		if (currentPeak.leftTrough.x < currentPeak.rightTrough.x)
-		{
-			for (size_t index = (size_t)currentPeak.leftTrough.x + 1; index <= currentPeak.rightTrough.x; ++index)
-			{
-				double b = data[index] + data[index - 1];
-				currentPeak.area += ((double)0.5 * b);
-			}
-		}
+		return (lhs.x == rhs.x) && (memcmp(&lhs.y, &rhs.y, sizeof(lhs.y)) == 0);
+	}
+
+	// Out of line, since it's rarely needed and would otherwise crowd the scanning loops.
+	double AreaPrefix::leaveOut(double trapezoid)
+	{
+		if (isnan(trapezoid))
+			++numNaN;
+		else if (trapezoid > (double)0.0)
+			++numPlusInf;
+		else
+			++numMinusInf;
+		return (double)0.0;
+	}
+
+	bool ThresholdScanner::sameState(const ThresholdScanner& rhs) const
+	{
+		return (index == rhs.index) &&
+			samePoint(currentPeak.leftTrough, rhs.currentPeak.leftTrough) &&
+			samePoint(currentPeak.peak, rhs.currentPeak.peak) &&
+			samePoint(currentPeak.rightTrough, rhs.currentPeak.rightTrough);
 	}
 
 	// Returns a list of peaks in the given array of numeric values. Only peaks that go above the given threshold will be counted.
 	GraphPeakList Peaks::findPeaksOverThreshold(double* data, size_t dataLen, size_t* numPeaks, double threshold)
 	{
-		std::vector<GraphPeak> peaks;
-		GraphPeak currentPeak;
+		ProfiledCall call;
 
-		for (size_t x = 0; x < dataLen; ++x)
-		{
-			double y = data[x];
-			
-			if (y < threshold)
-			{
-				// Have we found a peak? If so, add it and start looking for the next one.
-				if (currentPeak.rightTrough.x > 0)
-				{
-					// Still descending
-					if (y <= currentPeak.rightTrough.y)
-					{
-						currentPeak.rightTrough.x = x;
-						currentPeak.rightTrough.y = y;
-					}
-
-					// Rising
-					else
-					{
-						Peaks::computeArea(data, dataLen, currentPeak);
-						peaks.push_back(currentPeak);
-						currentPeak.clear();
-					}
-				}
-				
-				// Are we looking for a left trough?
-				else if (currentPeak.leftTrough.x == 0)
-				{
-					currentPeak.leftTrough.x = x;
-					currentPeak.leftTrough.y = y;
-				}
-				
-				// If we have a left trough and an existing peak, assume this is the right trough - for now.
-				else if ((currentPeak.peak.x > currentPeak.leftTrough.x) && (currentPeak.leftTrough.x > 0))
-				{
-					currentPeak.rightTrough.x = x;
-					currentPeak.rightTrough.y = y;
-				}
-				else
-				{
-					currentPeak.leftTrough.x = x;
-					currentPeak.leftTrough.y = y;
-				}
-			}
-			else if (currentPeak.leftTrough.x > 0) // Left trough is set.
-			{
-				// Are we looking for a peak or is this bigger than the current peak?
-				if (currentPeak.peak.x == 0 || y >= currentPeak.peak.y)
-				{
-					currentPeak.peak.x = x;
-					currentPeak.peak.y = y;
-				}
-			}
-			else if (currentPeak.rightTrough.x > 0) // Right trough is set.
-			{
-				Peaks::computeArea(data, dataLen, currentPeak);
-				peaks.push_back(currentPeak);
-				currentPeak.clear();
-			}
-			else // Nothing is set, but the value is above the threshold.
-			{
-				currentPeak.leftTrough.x = x;
-				currentPeak.leftTrough.y = y;
-			}
-		}
-		
+		GraphPeakList peaks = Peaks::scanOverThreshold(ArrayReader<double>(data), dataLen, threshold);
+		Peaks::setNumPeaks(numPeaks, peaks);
 		return peaks;
 	}
 
 	// Returns a list of peaks in the given array of numeric values. Only peaks that go above the given sigma line will be counted.
 	GraphPeakList Peaks::findPeaksOverStd(double* data, size_t dataLen, size_t* numPeaks, double sigmas)
-	{		
-		double mean = Peaks::average(data, dataLen);
-		double stddev = sigmas * Peaks::standardDeviation(data, dataLen, mean);
-		double threshold = mean + stddev;
-		return Peaks::findPeaksOverThreshold(data, dataLen, numPeaks, threshold);
-	}
-
-	// Computes the area of the given peak.
-	void Peaks::computeArea(const std::vector<double>& data, GraphPeak& currentPeak)
 	{
-		currentPeak.area = (double)0.0;
-		
-		if (currentPeak.leftTrough.x < currentPeak.rightTrough.x)
-		{
-			for (size_t index = (size_t)currentPeak.leftTrough.x + 1; index <= currentPeak.rightTrough.x; ++index)
-			{
-				double b = data.at(index) + data.at(index - 1);
-				currentPeak.area += ((double)0.5 * b);
-			}
-		}
+		ProfiledCall call;
+
+		GraphPeakList peaks = Peaks::scanOverStd(ArrayReader<double>(data), dataLen, sigmas);
+		Peaks::setNumPeaks(numPeaks, peaks);
+		return peaks;
 	}
 
-	// Returns a list of peaks in the given array of numeric values. Only peaks that go above the given threshold will be counted.
-	GraphPeakList Peaks::findPeaksOverThreshold(const std::vector<double>& data, double threshold)
+	// Same as above, but the peaks are written to the caller's buffer instead of a new list. numPeaks is set to the number
+	// of peaks found, which may be more than maxPeaks, and false is returned if the buffer was too small to hold them all.
+	bool Peaks::findPeaksOverThreshold(const double* data, size_t dataLen, GraphPeak* peaks, size_t maxPeaks, size_t* numPeaks, double threshold)
 	{
-		std::vector<GraphPeak> peaks;
-		GraphPeak currentPeak;
-
-		uint64_t x = 0;
+		ProfiledCall call;
 
-		for (auto iter = data.begin(); iter < data.end(); ++iter, ++x)
-		{
-			double y = *iter;
+		return Peaks::scanIntoBuffer(ArrayReader<double>(data), dataLen, threshold, peaks, maxPeaks, numPeaks);
+	}
 
-			if (y < threshold)
-			{
-				// Have we found a peak? If so, add it and start looking for the next one.
-				if (currentPeak.rightTrough.x > 0)
-				{
-					// Still descending
-					if (y <= currentPeak.rightTrough.y)
-					{
-						currentPeak.rightTrough.x = x;
-						currentPeak.rightTrough.y = y;
-					}
+	bool Peaks::findPeaksOverStd(const double* data, size_t dataLen, GraphPeak* peaks, size_t maxPeaks, size_t* numPeaks, double sigmas)
+	{
+		ProfiledCall call;
 
-					// Rising
-					else
-					{
-						Peaks::computeArea(data, currentPeak);
-						peaks.push_back(currentPeak);
-						currentPeak.clear();
-					}
-				}
+		ArrayReader<double> reader(data);
+		return Peaks::scanIntoBuffer(reader, dataLen, Peaks::thresholdOverStd(reader, dataLen, sigmas), peaks, maxPeaks, numPeaks);
+	}
 
-				// Are we looking for a left trough?
-				else if (currentPeak.leftTrough.x == 0)
-				{
-					currentPeak.leftTrough.x = x;
-					currentPeak.leftTrough.y = y;
-				}
+	// Same as above, but the peaks replace the contents of the given list, which only allocates when it needs to grow.
+	// Returns the number of peaks found.
+	size_t Peaks::findPeaksOverThreshold(const double* data, size_t dataLen, GraphPeakList& peaks, double threshold)
+	{
+		ProfiledCall call;
 
-				// If we have a left trough and an existing peak, assume this is the right trough - for now.
-				else if ((currentPeak.peak.x > currentPeak.leftTrough.x) && (currentPeak.leftTrough.x > 0))
-				{
-					currentPeak.rightTrough.x = x;
-					currentPeak.rightTrough.y = y;
-				}
-				else
-				{
-					currentPeak.leftTrough.x = x;
-					currentPeak.leftTrough.y = y;
-				}
-			}
-			else if (currentPeak.leftTrough.x > 0) // Left trough is set.
-			{
-				// Are we looking for a peak or is this bigger than the current peak?
-				if (currentPeak.peak.x == 0 || y >= currentPeak.peak.y)
-				{
-					currentPeak.peak.x = x;
-					currentPeak.peak.y = y;
-				}
-			}
-			else if (currentPeak.rightTrough.x > 0) // Right trough is set.
-			{
-				Peaks::computeArea(data, currentPeak);
-				peaks.push_back(currentPeak);
-				currentPeak.clear();
-			}
-			else // Nothing is set, but the value is above the threshold.
-			{
-				currentPeak.leftTrough.x = x;
-				currentPeak.leftTrough.y = y;
-			}
-		}
-		
-		return peaks;
+		return Peaks::scanIntoList(ArrayReader<double>(data), dataLen, threshold, peaks);
 	}
 
-	// Returns a list of peaks in the given array of numeric values. Only peaks that go above the given sigma line will be counted.
-	GraphPeakList Peaks::findPeaksOverStd(const std::vector<double>& data, double sigmas)
+	size_t Peaks::findPeaksOverStd(const double* data, size_t dataLen, GraphPeakList& peaks, double sigmas)
 	{
-		double mean = Peaks::average(data);
-		double stddev = sigmas * Peaks::standardDeviation(data, mean);
-		double threshold = mean + stddev;
-		return Peaks::findPeaksOverThreshold(data, threshold);
+		ProfiledCall call;
+
+		ArrayReader<double> reader(data);
+		return Peaks::scanIntoList(reader, dataLen, Peaks::thresholdOverStd(reader, dataLen, sigmas), peaks);
 	}
 
-	double Peaks::average(const double* data, size_t numPoints)
+#ifdef PEAKS_HAVE_PMR
+	// Same as above, for a list that allocates from a memory resource.
+	size_t Peaks::findPeaksOverThreshold(const double* data, size_t dataLen, pmr::GraphPeakList& peaks, double threshold)
 	{
-		double sum = 0;
+		ProfiledCall call;
 
-		for (auto index = 0; index < numPoints; index++)
-			sum = sum + data[index];
-		return sum / (double)numPoints;
+		return Peaks::scanIntoList(ArrayReader<double>(data), dataLen, threshold, peaks);
 	}
 
-	double Peaks::average(const std::vector<double>& data)
+	size_t Peaks::findPeaksOverStd(const double* data, size_t dataLen, pmr::GraphPeakList& peaks, double sigmas)
 	{
-		double sum = 0;
+		ProfiledCall call;
 
-		for (auto iter = data.begin(); iter != data.end(); ++iter)
-			sum = sum + (*iter);
-		return sum / (double)data.size();
+		ArrayReader<double> reader(data);
+		return Peaks::scanIntoList(reader, dataLen, Peaks::thresholdOverStd(reader, dataLen, sigmas), peaks);
 	}
+#endif
 
-	double Peaks::average(const GraphLine& data)
+	// Returns a list of peaks in the given array of numeric values. Only peaks that go above the given threshold will be counted.
+	GraphPeakList Peaks::findPeaksOverThreshold(const std::vector<double>& data, double threshold)
 	{
-		double sum = (double)0.0;
-		
-		for (auto iter = data.begin(); iter != data.end(); ++iter)
-			sum = sum + (*iter).y;
-		return sum / (double)data.size();
+		ProfiledCall call;
+
+		return Peaks::scanOverThreshold(ArrayReader<double>(data.data()), data.size(), threshold);
 	}
 
-	double Peaks::variance(const double* data, size_t numPoints, double mean)
+	// Returns a list of peaks in the given array of numeric values. Only peaks that go above the given sigma line will be counted.
+	GraphPeakList Peaks::findPeaksOverStd(const std::vector<double>& data, double sigmas)
 	{
-		double numerator = (double)0.0;
+		ProfiledCall call;
 
-		for (auto index = 0; index < numPoints; index++)
-			numerator = numerator + ((data[index] - mean) * (data[index] - mean));
-		return numerator / (double)(numPoints - 1);
+		return Peaks::scanOverStd(ArrayReader<double>(data.data()), data.size(), sigmas);
 	}
 
-	double Peaks::variance(const std::vector<double>& data, double mean)
+	// Returns a list of peaks in the given array of graph points. Only peaks that go above the given threshold will be counted.
+	// The troughs are tracked by the prefix sum at their position in the line rather than by searching for their x value
+	// afterwards, since x values needn't be unique.
+	GraphPeakList Peaks::findPeaksOverThreshold(const GraphLine& data, double threshold)
 	{
-		double numerator = (double)0.0;
+		ProfiledCall call;
 
-		for (auto iter = data.begin(); iter != data.end(); ++iter)
-			numerator = numerator + ((*iter - mean) * (*iter - mean));
-		return numerator / (double)(data.size() - 1);
+		return Peaks::scanOverThreshold(GraphLineReader(data.data()), data.size(), threshold);
 	}
 
-	double Peaks::variance(const GraphLine& data, double mean)
+	// Returns a list of peaks in the given array of graph points. Only peaks that go above the given sigma line will be counted.
+	GraphPeakList Peaks::findPeaksOverStd(const GraphLine& data, double sigmas)
 	{
-		double numerator = (double)0.0;
-		
-		for (auto iter = data.begin(); iter != data.end(); ++iter)
-			numerator = numerator + (((*iter).y - mean) * ((*iter).y - mean));
-		return numerator / (double)(data.size() - 1);
+		ProfiledCall call;
+
+		return Peaks::scanOverStd(GraphLineReader(data.data()), data.size(), sigmas);
 	}
 
-	double Peaks::standardDeviation(const double* data, size_t numPoints, double mean)
+	// Returns a list of peaks in the given array of graph points, with the area of each taken over the x distances between
+	// its points. Only peaks that go above the given threshold will be counted.
+	GraphPeakList Peaks::findPeaksOverThresholdTimeWeighted(const GraphLine& data, double threshold)
 	{
-		double var = variance(data, numPoints, mean);
-		return sqrt(var);
+		ProfiledCall call;
+
+		return Peaks::scanTimeWeighted(data, threshold);
 	}
 
-	double Peaks::standardDeviation(const std::vector<double>& data, double mean)
+	// Returns a list of peaks in the given array of graph points, with the area of each taken over the x distances between
+	// its points. Only peaks that go above the given sigma line will be counted.
+	GraphPeakList Peaks::findPeaksOverStdTimeWeighted(const GraphLine& data, double sigmas)
 	{
-		double var = variance(data, mean);
-		return sqrt(var);
+		ProfiledCall call;
+
+		return Peaks::scanTimeWeighted(data, Peaks::thresholdOverStd(TimeWeightedReader(data.data()), data.size(), sigmas));
 	}
 
-	double Peaks::standardDeviation(const GraphLine& data, double mean)
+	uint64_t Peaks::duration(const GraphPeak& peak)
 	{
-		double var = variance(data, mean);
-		return sqrt(var);
+		return peak.rightTrough.x - peak.leftTrough.x;
 	}
 
-	// Computes the area of the given peak.
-	void Peaks::computeArea(const GraphLine& data, GraphPeak& currentPeak)
+	// Returns a list of peaks for each of the given arrays. Only peaks that go above the channel's threshold will be counted.
+	std::vector<GraphPeakList> Peaks::findPeaksOverThreshold(const std::vector<const double*>& channels, size_t dataLen, const std::vector<double>& thresholds, size_t numThreads)
 	{
-		currentPeak.area = (double)0.0;
-		
-		if (currentPeak.leftTrough.x < currentPeak.rightTrough.x)
+		ProfiledCall call;
+
+		size_t numChannels = channels.size();
+		std::vector<GraphPeakList> channelPeaks(numChannels);
+
+		if (numThreads == 0)
+			numThreads = ThreadPool::defaultNumThreads();
+		numThreads = std::min(numThreads, numChannels);
+
+		if (numThreads <= 1)
+		{
+			for (size_t channel = 0; channel < numChannels; ++channel)
+				channelPeaks[channel] = Peaks::scanOverThreshold(ArrayReader<double>(channels[channel]), dataLen, thresholds.at(channel));
+		}
+		else
 		{
-			auto pointIter = std::find(data.begin(), data.end(), currentPeak.leftTrough);
+			ThreadPool pool(numThreads);
+			PeakStats* stats = PeakProfiler::current();
+			std::vector<PeakStats> channelStats(stats ? numChannels : 0);
 
-			if (pointIter != data.end())
+			for (size_t channel = 0; channel < numChannels; ++channel)
 			{
-				GraphPoint prevPoint = (*pointIter);
-				++pointIter;
+				double threshold = thresholds.at(channel);
+				pool.submit([&channels, &channelPeaks, &channelStats, dataLen, threshold, channel]() {
+					PeakProfiler profiler(channelStats.empty() ? NULL : &channelStats[channel]);
+					channelPeaks[channel] = Peaks::scanOverThreshold(ArrayReader<double>(channels[channel]), dataLen, threshold);
+				});
+			}
+			pool.wait();
 
-				for (; pointIter != data.end(); ++pointIter)
-				{
-					double b = (*pointIter).y + prevPoint.y;
-					currentPeak.area += ((double)0.5 * b);
-					prevPoint = (*pointIter);
-				}
+			if (stats)
+			{
+				for (auto iter = channelStats.begin(); iter != channelStats.end(); ++iter)
+					(*stats) += (*iter);
 			}
 		}
+		return channelPeaks;
 	}
 
-	// Returns a list of peaks in the given array of graph points. Only peaks that go above the given threshold will be counted.
-	GraphPeakList Peaks::findPeaksOverThreshold(const GraphLine& data, double threshold)
+	// Returns a list of peaks for each of the given columns of an interleaved buffer. Only peaks that go above the channel's threshold will be counted.
+	std::vector<GraphPeakList> Peaks::findPeaksOverThresholdInterleaved(const double* frames, size_t numFrames, size_t frameLen, const std::vector<size_t>& columns, const std::vector<double>& thresholds)
 	{
-		std::vector<GraphPeak> peaks;
-		GraphPeak currentPeak;
+		ProfiledCall call;
+
+		size_t numChannels = columns.size();
+		std::vector<GraphPeakList> channelPeaks(numChannels);
+		std::vector<StreamingPeakFinder> finders;
 
-		for (auto iter = data.begin(); iter < data.end(); ++iter)
+		finders.reserve(numChannels);
+		for (size_t channel = 0; channel < numChannels; ++channel)
 		{
-			const GraphPoint& pt = *iter;
+			GraphPeakList& peaks = channelPeaks[channel];
+			finders.push_back(StreamingPeakFinder(thresholds.at(channel), [&peaks](const GraphPeak& peak) { peaks.push_back(peak); }));
+		}
 
-			if (pt.y < threshold)
-			{
-				// Have we found a peak? If so, add it and start looking for the next one.
-				if (currentPeak.rightTrough.x > 0) // Right trough is set
+		uint64_t start = PeakProfiler::current() ? PeakProfiler::now() : 0;
+		const double* frame = frames;
+		for (size_t x = 0; x < numFrames; ++x, frame += frameLen)
+		{
+			for (size_t channel = 0; channel < numChannels; ++channel)
+				finders[channel].push(frame[columns[channel]]);
+		}
+
+		for (size_t channel = 0; channel < numChannels; ++channel)
+			Peaks::addListStats(channelPeaks[channel], numFrames, (channel == 0) ? start : 0);
+		return channelPeaks;
+	}
+
+	// Scans one chunk for findPeaksOverThresholdInChunks, remembering the sample at which each peak was reported.
+	template <typename Profiler>
+	static void scanChunk(ThresholdScanner& scanner, const double* data, size_t dataLen, double threshold, GraphPeakList& peaks, std::vector<uint64_t>& emitted, Profiler& profiler)
+	{
+		uint64_t start = profiler.startPhase();
+
+		scanner.scan(ArrayReader<double>(data), dataLen, threshold, [&peaks, &emitted, &profiler](const GraphPeak& peak, uint64_t index) {
+			profiler.append(peaks, peak);
+			emitted.push_back(index);
+		}, profiler);
+		profiler.endPhase(PeakStats::PHASE_SCAN, start);
+	}
+
+	// Chunked implementation of findPeaksOverThresholdParallel.
+	//
+	// Chunks start on AreaPrefix block boundaries. The first pass sums each block on its own, in parallel, and the block
+	// bases are then chained together in order, which gives every chunk the exact prefix the serial scan would have at
+	// its first sample. The second pass runs a ThresholdScanner over each chunk, in parallel, starting with no partial
+	// peak. That guess is only wrong until the chunk's scanner reaches the same state as one carrying on from the previous
+	// chunk, which usually happens within a peak or two; so the stitching pass replays each chunk from the true state
+	// alongside a replica of the speculative scanner until the two agree, keeps the peaks the true scanner reported up to
+	// there, and takes the rest from the chunk.
+	GraphPeakList Peaks::findPeaksOverThresholdInChunks(const double* data, size_t dataLen, double threshold, size_t numThreads)
+	{
+		const size_t CHUNKS_PER_THREAD = 4; // Extra chunks even out the load when peak density varies
+		const uint64_t BLOCK_SIZE = AreaPrefix::BLOCK_SIZE;
+
+		size_t numBlocks = (dataLen + BLOCK_SIZE - 1) / BLOCK_SIZE;
+		size_t numChunks = std::min(numThreads * CHUNKS_PER_THREAD, numBlocks);
+		size_t blocksPerChunk = (numBlocks + numChunks - 1) / numChunks;
+		numChunks = (numBlocks + blocksPerChunk - 1) / blocksPerChunk;
+
+		ThreadPool pool(numThreads);
+		PeakStats* stats = PeakProfiler::current();
+		uint64_t start = stats ? PeakProfiler::now() : 0;
+
+		// Sum of the trapezoids within each block.
+		std::vector<AreaPrefix> blockPrefixes(numBlocks);
+		for (size_t chunk = 0; chunk < numChunks; ++chunk)
+		{
+			pool.submit([&, chunk]() {
+				size_t lastBlock = std::min((chunk + 1) * blocksPerChunk, numBlocks);
+
+				for (size_t block = chunk * blocksPerChunk; block < lastBlock; ++block)
 				{
-					// Still descending
-					if (pt.y <= currentPeak.rightTrough.y)
-					{
-						currentPeak.rightTrough.x = pt.x;
-						currentPeak.rightTrough.y = pt.y;
-					}
+					size_t start = block * BLOCK_SIZE;
+					size_t end = std::min(start + BLOCK_SIZE, dataLen);
+					AreaPrefix prefix;
+
+					for (size_t x = start + 1; x < end; ++x)
+						prefix.advanceUnchecked(x, data[x - 1], data[x]);
 
-					// Rising
-					else
+					// A NaN or infinite sample in the block: sum it again, leaving those out.
+					if (!prefix.isFinite())
 					{
-						Peaks::computeArea(data, currentPeak);
-						peaks.push_back(currentPeak);
-						currentPeak.clear();
+						prefix.clear();
+						for (size_t x = start + 1; x < end; ++x)
+							prefix.advance(x, data[x - 1], data[x]);
 					}
+					blockPrefixes[block] = prefix;
 				}
+			});
+		}
+		pool.wait();
+
+		// Prefix at the sample before each chunk, chained in the same order as the serial scan.
+		std::vector<AreaPrefix> chunkPrefixes(numChunks);
+		AreaPrefix prefix;
+		for (size_t block = 0; block < numBlocks; ++block)
+		{
+			if (block > 0)
+				prefix.advance(block * BLOCK_SIZE, data[block * BLOCK_SIZE - 1], data[block * BLOCK_SIZE]);
+			prefix.offset = blockPrefixes[block].offset;
+			prefix.addNonFinite(blockPrefixes[block]);
+
+			if ((block + 1) % blocksPerChunk == 0 && (block + 1) / blocksPerChunk < numChunks)
+				chunkPrefixes[(block + 1) / blocksPerChunk] = prefix;
+		}
 
-				// Are we looking for a left trough?
-				else if (currentPeak.leftTrough.x == 0) // Left trough is not set.
+		if (stats)
+			stats->phaseNanoseconds[PeakStats::PHASE_AREA] += PeakProfiler::now() - start;
+
+		// Speculative pass over each chunk.
+		std::vector<ThresholdScanner> scanners(numChunks);
+		std::vector<GraphPeakList> chunkPeaks(numChunks);
+		std::vector<std::vector<uint64_t>> chunkEmitted(numChunks);
+		std::vector<PeakStats> chunkStats(stats ? numChunks : 0);
+		for (size_t chunk = 0; chunk < numChunks; ++chunk)
+		{
+			pool.submit([&, chunk]() {
+				size_t start = chunk * blocksPerChunk * BLOCK_SIZE;
+				size_t end = std::min(start + (blocksPerChunk * BLOCK_SIZE), dataLen);
+				ThresholdScanner& scanner = scanners[chunk];
+
+				if (chunk > 0)
 				{
-					currentPeak.leftTrough = pt;
+					scanner.index = start;
+					scanner.prevY = data[start - 1];
+					scanner.prefix = chunkPrefixes[chunk];
 				}
 
-				// If we have a left trough and an existing peak, assume this is the right trough - for now.
-				else if ((currentPeak.peak.x > currentPeak.leftTrough.x) && (currentPeak.leftTrough.x > 0))
+				if (chunkStats.empty())
 				{
-					currentPeak.rightTrough = pt;
+					NoProfiling profiler;
+					scanChunk(scanner, data + start, end - start, threshold, chunkPeaks[chunk], chunkEmitted[chunk], profiler);
 				}
 				else
 				{
-					currentPeak.leftTrough = pt;
+					Profiling profiler(chunkStats[chunk]);
+					scanChunk(scanner, data + start, end - start, threshold, chunkPeaks[chunk], chunkEmitted[chunk], profiler);
 				}
+			});
+		}
+		pool.wait();
+
+		// Stitch the chunks together.
+		start = stats ? PeakProfiler::now() : 0;
+		std::vector<GraphPeak> peaks = chunkPeaks[0];
+		ThresholdScanner trueScanner = scanners[0];
+
+		for (size_t chunk = 1; chunk < numChunks; ++chunk)
+		{
+			size_t start = chunk * blocksPerChunk * BLOCK_SIZE;
+			size_t end = std::min(start + (blocksPerChunk * BLOCK_SIZE), dataLen);
+			ThresholdScanner replica;
+			bool converged = false;
+
+			replica.index = start;
+			replica.prevY = data[start - 1];
+			replica.prefix = chunkPrefixes[chunk];
+
+			for (size_t x = start; x < end && !converged; ++x)
+			{
+				if (trueScanner.step(x, data[x], threshold) == ThresholdScanner::STEP_PEAK)
+					peaks.push_back(trueScanner.foundPeak);
+				replica.step(x, data[x], threshold);
+				converged = trueScanner.sameState(replica);
 			}
-			else if (currentPeak.leftTrough.x > 0) // Left trough is set.
+
+			if (converged)
 			{
-				// Are we looking for a peak or is this bigger than the current peak, making it the real peak?
-				if (currentPeak.peak.x == 0 || pt.y >= currentPeak.peak.y)
+				uint64_t agreedAt = trueScanner.index - 1;
+				const std::vector<uint64_t>& emitted = chunkEmitted[chunk];
+
+				for (size_t i = 0; i < emitted.size(); ++i)
 				{
-					currentPeak.peak = pt;
+					if (emitted[i] > agreedAt)
+						peaks.push_back(chunkPeaks[chunk][i]);
 				}
+
+				trueScanner = scanners[chunk];
 			}
-			else if (currentPeak.rightTrough.x > 0) // Right trough is set.
-			{
-				Peaks::computeArea(data, currentPeak);
-				peaks.push_back(currentPeak);
-				currentPeak.clear();
-			}
-			else // Nothing is set, but the value is above the threshold.
+		}
+
+		// Some of the peaks the chunks found were replaced while stitching, so count the ones that are left instead.
+		if (stats)
+		{
+			for (auto iter = chunkStats.begin(); iter != chunkStats.end(); ++iter)
 			{
-				currentPeak.leftTrough = pt;
+				(*iter).peaksEmitted = 0;
+				(*stats) += (*iter);
 			}
+			stats->peaksEmitted += peaks.size();
+			stats->bytesAllocated += peaks.capacity() * sizeof(GraphPeak);
+			stats->phaseNanoseconds[PeakStats::PHASE_SCAN] += PeakProfiler::now() - start;
 		}
-		
 		return peaks;
 	}
 
+	// Returns a list of peaks in the given array of numeric values. Only peaks that go above the given threshold will be counted.
+	GraphPeakList Peaks::findPeaksOverThresholdParallel(double* data, size_t dataLen, size_t* numPeaks, double threshold, size_t numThreads)
+	{
+		ProfiledCall call;
+
+		if (numThreads == 0)
+			numThreads = ThreadPool::defaultNumThreads();
+
+		GraphPeakList peaks;
+		if (numThreads == 1 || dataLen <= AreaPrefix::BLOCK_SIZE)
+			peaks = Peaks::scanOverThreshold(ArrayReader<double>(data), dataLen, threshold);
+		else
+			peaks = Peaks::findPeaksOverThresholdInChunks(data, dataLen, threshold, numThreads);
+		Peaks::setNumPeaks(numPeaks, peaks);
+		return peaks;
+	}
+
+	// Returns a list of peaks in the given array of numeric values. Only peaks that go above the given threshold will be counted.
+	GraphPeakList Peaks::findPeaksOverThresholdParallel(const std::vector<double>& data, double threshold, size_t numThreads)
+	{
+		ProfiledCall call;
+
+		if (numThreads == 0)
+			numThreads = ThreadPool::defaultNumThreads();
+		if (numThreads == 1 || data.size() <= AreaPrefix::BLOCK_SIZE)
+			return Peaks::findPeaksOverThreshold(data, threshold);
+		return Peaks::findPeaksOverThresholdInChunks(data.data(), data.size(), threshold, numThreads);
+	}
+
+	// Returns a list of peaks in the given array of numeric values. Only peaks that go above the given sigma line will be counted.
+	GraphPeakList Peaks::findPeaksOverStdSinglePass(double* data, size_t dataLen, size_t* numPeaks, double sigmas)
+	{
+		ProfiledCall call;
+
+		double mean, variance;
+		PeakStats* stats = PeakProfiler::current();
+		uint64_t start = stats ? PeakProfiler::now() : 0;
+
+		VectorStats::meanAndVariance(data, dataLen, mean, variance);
+
+		if (stats)
+			stats->phaseNanoseconds[PeakStats::PHASE_STATS] += PeakProfiler::now() - start;
+
+		double threshold = mean + (sigmas * sqrt(variance));
+		return Peaks::findPeaksOverThreshold(data, dataLen, numPeaks, threshold);
+	}
+
+	// Returns a list of peaks in the given array of numeric values. Only peaks that go above the given sigma line will be counted.
+	GraphPeakList Peaks::findPeaksOverStdSinglePass(const std::vector<double>& data, double sigmas)
+	{
+		ProfiledCall call;
+
+		double mean, variance;
+		PeakStats* stats = PeakProfiler::current();
+		uint64_t start = stats ? PeakProfiler::now() : 0;
+
+		VectorStats::meanAndVariance(data.data(), data.size(), mean, variance);
+
+		if (stats)
+			stats->phaseNanoseconds[PeakStats::PHASE_STATS] += PeakProfiler::now() - start;
+
+		double threshold = mean + (sigmas * sqrt(variance));
+		return Peaks::findPeaksOverThreshold(data, threshold);
+	}
+
+	// Returns a list of peaks in the given array of numeric values after smoothing. Only peaks that go above the threshold will be counted.
+	GraphPeakList Peaks::findPeaksOverThreshold(const double* data, size_t dataLen, const Prefilter& filter, double threshold)
+	{
+		ProfiledCall call;
+		return Peaks::scanFiltered(ArrayReader<double>(data), dataLen, filter, threshold);
+	}
+
+	// Returns a list of peaks in the given vector of numeric values after smoothing. Only peaks that go above the threshold will be counted.
+	GraphPeakList Peaks::findPeaksOverThreshold(const std::vector<double>& data, const Prefilter& filter, double threshold)
+	{
+		ProfiledCall call;
+		return Peaks::scanFiltered(ArrayReader<double>(data.data()), data.size(), filter, threshold);
+	}
+
+	// Returns a list of peaks in the given array of numeric values. Only peaks that go above the rolling sigma line will be counted.
+	GraphPeakList Peaks::findPeaksOverRollingStd(double* data, size_t dataLen, size_t* numPeaks, size_t windowSize, double sigmas)
+	{
+		ProfiledCall call;
+
+		std::vector<GraphPeak> peaks;
+		StreamingPeakFinder finder(windowSize, sigmas, [&peaks](const GraphPeak& peak) { peaks.push_back(peak); });
+		uint64_t start = PeakProfiler::current() ? PeakProfiler::now() : 0;
+
+		finder.push(data, dataLen);
+		Peaks::addListStats(peaks, dataLen, start);
+		Peaks::setNumPeaks(numPeaks, peaks);
+		return peaks;
+	}
+
+	// Returns a list of peaks in the given array of numeric values. Only peaks that go above the rolling sigma line will be counted.
+	GraphPeakList Peaks::findPeaksOverRollingStd(const std::vector<double>& data, size_t windowSize, double sigmas)
+	{
+		ProfiledCall call;
+
+		std::vector<GraphPeak> peaks;
+		StreamingPeakFinder finder(windowSize, sigmas, [&peaks](const GraphPeak& peak) { peaks.push_back(peak); });
+		uint64_t start = PeakProfiler::current() ? PeakProfiler::now() : 0;
+
+		finder.push(data.data(), data.size());
+		Peaks::addListStats(peaks, data.size(), start);
+		return peaks;
+	}
+
+	void Peaks::setNumPeaks(size_t* numPeaks, const GraphPeakList& peaks)
+	{
+		if (numPeaks)
+			*numPeaks = peaks.size();
+	}
+
+	// The scanner reports sample indices, which are swapped for the x values at them as each peak is found.
+	GraphPeakList Peaks::scanTimeWeighted(const GraphLine& data, double threshold)
+	{
+		GraphPeakList peaks;
+		ThresholdScanner scanner;
+		uint64_t start = PeakProfiler::current() ? PeakProfiler::now() : 0;
+
+		scanner.scan(TimeWeightedReader(data.data()), data.size(), threshold, [&peaks, &data](const GraphPeak& peak, uint64_t) {
+			peaks.push_back(peak);
+
+			GraphPeak& timed = peaks.back();
+			timed.leftTrough.x = data[peak.leftTrough.x].x;
+			timed.peak.x = data[peak.peak.x].x;
+			timed.rightTrough.x = data[peak.rightTrough.x].x;
+		});
+		Peaks::addListStats(peaks, data.size(), start);
+		return peaks;
+	}
+
+	// For the functions that are built on StreamingPeakFinder, which isn't instrumented: counts a list of peaks found
+	// in numSamples samples, and the time since start (if not zero) as the scan. The state transitions aren't counted,
+	// and the stats, which are kept as the scan goes, are counted as part of it.
+	void Peaks::addListStats(const GraphPeakList& peaks, size_t numSamples, uint64_t start)
+	{
+		PeakStats* stats = PeakProfiler::current();
+
+		if (stats)
+		{
+			stats->samplesScanned += numSamples;
+			stats->peaksEmitted += peaks.size();
+			stats->bytesAllocated += peaks.capacity() * sizeof(GraphPeak);
+			if (start > 0)
+				stats->phaseNanoseconds[PeakStats::PHASE_SCAN] += PeakProfiler::now() - start;
+		}
+	}
+
+	double Peaks::average(const ArrayReader<double>& data, size_t dataLen)
+	{
+		return VectorStats::average(data.data(), dataLen);
+	}
+
+	double Peaks::variance(const ArrayReader<double>& data, size_t dataLen, double mean)
+	{
+		return VectorStats::sumOfSquaredDeviations(data.data(), dataLen, mean) / (double)(dataLen - 1);
+	}
+
 	// Returns a list of peaks in the given array of graph points. Only peaks that go above the given sigma line will be counted.
-	GraphPeakList Peaks::findPeaksOverStd(const GraphLine& data, double sigmas)
+	GraphPeakList Peaks::findPeaksOverStdSinglePass(const GraphLine& data, double sigmas)
 	{
-		double mean = average(data);
-		double stddev = sigmas * standardDeviation(data, mean);
-		double threshold = mean + stddev;
+		ProfiledCall call;
+
+		RunningStats stats;
+		PeakStats* profile = PeakProfiler::current();
+		uint64_t start = profile ? PeakProfiler::now() : 0;
+
+		for (auto iter = data.begin(); iter != data.end(); ++iter)
+			stats.push((*iter).y);
+
+		if (profile)
+			profile->phaseNanoseconds[PeakStats::PHASE_STATS] += PeakProfiler::now() - start;
+
+		double threshold = stats.mean() + (sigmas * stats.standardDeviation());
 		return Peaks::findPeaksOverThreshold(data, threshold);
 	}
 }
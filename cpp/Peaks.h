@@ -29,22 +29,34 @@
 #include <stdlib.h>
 #include <vector>
 
+#include "MonotonicArena.h"
+#include "PeakStats.h"
+#include "Prefilter.h"
+#include "SampleView.h"
+#include "VectorScan.h"
+
 namespace Peaks
 {
 	/**
-	 * Defines a point. X values are integers. Y values are floating point.
+	 * Defines a point. X values are integers. Y values are floating point by default, but both can be narrower types
+	 * (see CompactGraphPoint) where memory is tight.
 	 */
-	class GraphPoint
+	template <typename X, typename Y>
+	class BasicGraphPoint
 	{
 	public:
-		uint64_t x;
-		double y;
+		X x;
+		Y y;
 		
-		GraphPoint() { x = 0; y = (double)0.0; }
-		GraphPoint(uint64_t newX, double newY) { x = newX; y = newY; }
-		GraphPoint(const GraphPoint& rhs) { x = rhs.x; y = rhs.y; }
+		BasicGraphPoint() { x = 0; y = (Y)0; }
+		BasicGraphPoint(X newX, Y newY) { x = newX; y = newY; }
+		BasicGraphPoint(const BasicGraphPoint& rhs) { x = rhs.x; y = rhs.y; }
+
+		// Conversion between point types. Narrowing is up to the caller, so it has to be asked for.
+		template <typename X2, typename Y2>
+		explicit BasicGraphPoint(const BasicGraphPoint<X2, Y2>& rhs) { x = (X)rhs.x; y = (Y)rhs.y; }
 		
-		GraphPoint& operator=(const GraphPoint& rhs)
+		BasicGraphPoint& operator=(const BasicGraphPoint& rhs)
 		{
 			x = rhs.x;
 			y = rhs.y;
@@ -58,47 +70,63 @@ namespace Peaks
 			return fabs(a - b) <= ( (absA < absB ? absB : absA * epsilon) );
 		}
 
-		bool operator==(const GraphPoint& rhs) const
+		bool operator==(const BasicGraphPoint& rhs) const
 		{
-			bool xEqual = roughlyEqual(x, rhs.x, (double)0.0001);
-			bool yEqual = roughlyEqual(y, rhs.y, (double)0.0001);
+			bool xEqual = roughlyEqual((double)x, (double)rhs.x, (double)0.0001);
+			bool yEqual = roughlyEqual((double)y, (double)rhs.y, (double)0.0001);
 			return xEqual && yEqual;
 		}
 		
 		void clear()
 		{
 			x = 0;
-			y = (double)0.0;
+			y = (Y)0;
 		}
 	};
 
+	typedef BasicGraphPoint<uint64_t, double> GraphPoint;
+
 	/**
 	 * List of points.
 	 */
-	typedef std::vector<GraphPoint> GraphLine;
+	template <typename X, typename Y>
+	using BasicGraphLine = std::vector<BasicGraphPoint<X, Y>>;
+
+	typedef BasicGraphLine<uint64_t, double> GraphLine;
 
 	/**
 	 * Defines a peak. A peak is described by three points: a left trough, a peak, and a right trough.
+	 * The area is always a double, whatever the point type, since it is a sum over every sample in the peak.
 	 */
-	class GraphPeak
+	template <typename X, typename Y>
+	class BasicGraphPeak
 	{
 	public:
-		GraphPoint leftTrough;
-		GraphPoint peak;
-		GraphPoint rightTrough;
+		BasicGraphPoint<X, Y> leftTrough;
+		BasicGraphPoint<X, Y> peak;
+		BasicGraphPoint<X, Y> rightTrough;
 		double area;
 		
-		GraphPeak() { clear(); }
+		BasicGraphPeak() { clear(); }
 		
-		GraphPeak(const GraphPeak& rhs)
+		BasicGraphPeak(const BasicGraphPeak& rhs)
 		{
 			leftTrough = rhs.leftTrough;
 			peak = rhs.peak;
 			rightTrough = rhs.rightTrough;
 			area = rhs.area;
 		}
+
+		template <typename X2, typename Y2>
+		explicit BasicGraphPeak(const BasicGraphPeak<X2, Y2>& rhs) :
+			leftTrough(rhs.leftTrough),
+			peak(rhs.peak),
+			rightTrough(rhs.rightTrough),
+			area(rhs.area)
+		{
+		}
 		
-		GraphPeak& operator=(const GraphPeak& rhs)
+		BasicGraphPeak& operator=(const BasicGraphPeak& rhs)
 		{
 			leftTrough = rhs.leftTrough;
 			peak = rhs.peak;
@@ -107,13 +135,13 @@ namespace Peaks
 			return *this;
 		}
 		
-		bool operator==(const GraphPeak& rhs) const
+		bool operator==(const BasicGraphPeak& rhs) const
 		{
 			return (leftTrough == rhs.leftTrough) && (peak == rhs.peak) && (rightTrough == rhs.rightTrough);
 		}
 		
-		bool operator < (const GraphPeak& rhs) const { return (area < rhs.area); }
-		bool operator > (const GraphPeak& rhs) const { return (area > rhs.area); }
+		bool operator < (const BasicGraphPeak& rhs) const { return (area < rhs.area); }
+		bool operator > (const BasicGraphPeak& rhs) const { return (area > rhs.area); }
 		
 		void clear()
 		{
@@ -124,10 +152,565 @@ namespace Peaks
 		}
 	};
 
+	typedef BasicGraphPeak<uint64_t, double> GraphPeak;
+
 	/**
 	 * List of peaks.
 	 */
-	typedef std::vector<GraphPeak> GraphPeakList;
+	template <typename X, typename Y>
+	using BasicGraphPeakList = std::vector<BasicGraphPeak<X, Y>>;
+
+	typedef BasicGraphPeakList<uint64_t, double> GraphPeakList;
+
+	/**
+	 * Half size points and peaks, for small devices: 32-bit indices and float values, which hold int16_t samples
+	 * exactly. A CompactGraphPoint is 8 bytes and a CompactGraphPeak 32, against 16 and 56.
+	 */
+	typedef BasicGraphPoint<uint32_t, float> CompactGraphPoint;
+	typedef BasicGraphLine<uint32_t, float> CompactGraphLine;
+	typedef BasicGraphPeak<uint32_t, float> CompactGraphPeak;
+	typedef BasicGraphPeakList<uint32_t, float> CompactGraphPeakList;
+
+#ifdef PEAKS_HAVE_PMR
+	/**
+	 * Lists that allocate from a std::pmr::memory_resource, such as a MonotonicArena that is reset between jobs.
+	 */
+	namespace pmr
+	{
+		typedef std::pmr::vector<GraphPeak> GraphPeakList;
+		typedef std::pmr::vector<CompactGraphPeak> CompactGraphPeakList;
+	}
+#endif
+
+	/**
+	 * Running trapezoid prefix sum. The area under the line between two samples is the difference of the prefix
+	 * at each of them, so a peak's area is available in constant time once both of its troughs are known.
+	 * The sum is kept as a per-block base plus an offset within the block so that the precision of the
+	 * difference doesn't degrade on very long inputs.
+	 *
+	 * Trapezoids that are NaN or infinite are counted instead of being added, so that a bad sample only spoils the
+	 * areas that include it, which come out as NaN or infinite just as a direct sum over the peak would.
+	 */
+	class AreaPrefix
+	{
+	public:
+		static const uint64_t BLOCK_SIZE = 4096;
+
+		double base;   // Sum of all of the blocks before the current one
+		double offset; // Sum within the current block
+		uint32_t numNaN;      // Trapezoids left out of the sum because they were NaN,
+		uint32_t numPlusInf;  // +inf,
+		uint32_t numMinusInf; // or -inf
+
+		AreaPrefix() { clear(); }
+
+		// Extends the sum by the trapezoid between the samples at (index - 1) and index, which are width apart.
+		void advance(uint64_t index, double prevY, double y, double width = 1.0)
+		{
+			double b = y + prevY;
+			double trapezoid = ((double)0.5 * b) * width;
+
+			if (!isfinite(trapezoid))
+				trapezoid = leaveOut(trapezoid);
+			add(index, trapezoid);
+		}
+
+		// Same as above, but without checking the trapezoid. For loops over many samples, which check isFinite() at the
+		// end and, if it's false, sum the same samples again with advance().
+		void advanceUnchecked(uint64_t index, double prevY, double y, double width = 1.0)
+		{
+			double b = y + prevY;
+			add(index, ((double)0.5 * b) * width);
+		}
+
+		bool isFinite() const { return isfinite(base) && isfinite(offset); }
+
+		// Area between the sample this prefix was taken at and the sample the given prefix was taken at.
+		double areaTo(const AreaPrefix& rhs) const
+		{
+			bool hasNaN = rhs.numNaN != numNaN;
+			bool hasPlusInf = rhs.numPlusInf != numPlusInf;
+			bool hasMinusInf = rhs.numMinusInf != numMinusInf;
+
+			if (hasNaN || (hasPlusInf && hasMinusInf))
+				return (double)NAN;
+			if (hasPlusInf)
+				return (double)INFINITY;
+			if (hasMinusInf)
+				return -(double)INFINITY;
+			return (rhs.base - base) + (rhs.offset - offset);
+		}
+
+		// Adds the counts of non-finite trapezoids from a prefix that was summed separately, such as one block of a longer input.
+		void addNonFinite(const AreaPrefix& rhs)
+		{
+			numNaN += rhs.numNaN;
+			numPlusInf += rhs.numPlusInf;
+			numMinusInf += rhs.numMinusInf;
+		}
+
+		bool hasNonFinite() const { return (numNaN + numPlusInf + numMinusInf) > 0; }
+
+		void clear()
+		{
+			base = (double)0.0;
+			offset = (double)0.0;
+			numNaN = 0;
+			numPlusInf = 0;
+			numMinusInf = 0;
+		}
+
+	private:
+		void add(uint64_t index, double trapezoid)
+		{
+			if (index % BLOCK_SIZE == 0)
+			{
+				base = base + (offset + trapezoid);
+				offset = (double)0.0;
+			}
+			else
+			{
+				offset = offset + trapezoid;
+			}
+		}
+
+		double leaveOut(double trapezoid); // Counts a trapezoid that isn't finite, and returns zero to add instead
+	};
+
+	/**
+	 * Returns the end of the run of samples in [from, to) that would only move a trough: samples below the threshold
+	 * or, when descending, samples below the threshold that are no greater than the sample before them.
+	 */
+	template <typename Reader>
+	size_t findEndOfTroughRun(const Reader& data, size_t from, size_t to, double threshold, bool descending)
+	{
+		if (descending)
+		{
+			while ((from < to) && (data.y(from) < threshold) && (data.y(from) <= data.y(from - 1)))
+				++from;
+		}
+		else
+		{
+			while ((from < to) && (data.y(from) < threshold))
+				++from;
+		}
+		return from;
+	}
+
+	/**
+	 * Sample readers for ThresholdScanner::scan. Each gives the y value of the sample at a position, its x value (the
+	 * sample index, except for graph lines, which carry their own), its distance from the sample before it (one, except
+	 * in time-weighted mode) and the end of a trough run starting at a position.
+	 */
+	template <typename T>
+	class ArrayReader
+	{
+	public:
+		ArrayReader(const T* data) : m_data(data) {}
+
+		const T* data() const { return m_data; }
+		double y(size_t i) const { return (double)m_data[i]; }
+		uint64_t x(size_t, uint64_t index) const { return index; }
+		double width(size_t) const { return (double)1.0; }
+		size_t runEnd(size_t from, size_t to, double threshold, bool descending) const { return findEndOfTroughRun(*this, from, to, threshold, descending); }
+
+	private:
+		const T* m_data;
+	};
+
+	// Arrays of doubles, floats and int16_t samples are searched a vector at a time.
+	template <>
+	inline size_t ArrayReader<double>::runEnd(size_t from, size_t to, double threshold, bool descending) const
+	{
+		if (descending)
+			return VectorScan::findEndOfDescent(m_data, from, to, threshold);
+		return VectorScan::findFirstAtOrAbove(m_data, from, to, threshold);
+	}
+
+	template <>
+	inline size_t ArrayReader<float>::runEnd(size_t from, size_t to, double threshold, bool descending) const
+	{
+		if (descending)
+			return VectorScan::findEndOfDescent(m_data, from, to, threshold);
+		return VectorScan::findFirstAtOrAbove(m_data, from, to, threshold);
+	}
+
+	template <>
+	inline size_t ArrayReader<int16_t>::runEnd(size_t from, size_t to, double threshold, bool descending) const
+	{
+		if (descending)
+			return VectorScan::findEndOfDescent(m_data, from, to, threshold);
+		return VectorScan::findFirstAtOrAbove(m_data, from, to, threshold);
+	}
+
+	template <typename T>
+	class StridedReader
+	{
+	public:
+		StridedReader(const SampleView<T>& view) : m_view(view) {}
+
+		double y(size_t i) const { return (double)m_view[i]; }
+		uint64_t x(size_t, uint64_t index) const { return index; }
+		double width(size_t) const { return (double)1.0; }
+		size_t runEnd(size_t from, size_t to, double threshold, bool descending) const { return findEndOfTroughRun(*this, from, to, threshold, descending); }
+
+	private:
+		SampleView<T> m_view;
+	};
+
+	template <typename Point>
+	class BasicGraphLineReader
+	{
+	public:
+		BasicGraphLineReader(const Point* points) : m_points(points) {}
+
+		double y(size_t i) const { return (double)m_points[i].y; }
+		uint64_t x(size_t i, uint64_t) const { return (uint64_t)m_points[i].x; }
+		double width(size_t) const { return (double)1.0; }
+
+		// Runs aren't skipped, since a point with an x value of zero would unset the trough part way through one.
+		size_t runEnd(size_t from, size_t, double, bool) const { return from; }
+
+	private:
+		const Point* m_points;
+	};
+
+	typedef BasicGraphLineReader<GraphPoint> GraphLineReader;
+
+	// Time-weighted mode: each point counts for the x distance from the one before it. The scanner is given the sample
+	// index as the x value, so repeated or zero x values can't confuse it, and the x values are looked up afterwards.
+	class TimeWeightedReader
+	{
+	public:
+		TimeWeightedReader(const GraphPoint* points) : m_points(points) {}
+
+		double y(size_t i) const { return m_points[i].y; }
+		uint64_t x(size_t, uint64_t index) const { return index; }
+		double width(size_t i) const { return (i > 0) ? ((double)m_points[i].x - (double)m_points[i - 1].x) : (double)0.0; }
+		size_t runEnd(size_t from, size_t to, double threshold, bool descending) const { return findEndOfTroughRun(*this, from, to, threshold, descending); }
+
+	private:
+		const GraphPoint* m_points;
+	};
+
+	/**
+	 * Profiling policies for the scanning templates. The peak finders are instantiated with NoProfiling, which compiles
+	 * away, unless a PeakProfiler is collecting on the calling thread, in which case Profiling counts into its stats.
+	 */
+	class NoProfiling
+	{
+	public:
+		void scanned(size_t) {}
+		void transition() {}
+		void found() {}
+		template <typename Peak, typename Allocator>
+		void append(std::vector<Peak, Allocator>& peaks, const GraphPeak& peak) { peaks.push_back(Peak(peak)); }
+		uint64_t startPhase() { return 0; }
+		void endPhase(PeakStats::Phase, uint64_t) {}
+	};
+
+	class Profiling
+	{
+	public:
+		Profiling(PeakStats& stats) : m_stats(stats), m_allocationMark(0) {}
+
+		void scanned(size_t numSamples) { m_stats.samplesScanned += numSamples; }
+		void transition() { ++m_stats.stateTransitions; }
+		void found() { ++m_stats.peaksEmitted; }
+
+		// Adds a peak to a list, timing it if the list has to grow.
+		template <typename Peak, typename Allocator>
+		void append(std::vector<Peak, Allocator>& peaks, const GraphPeak& peak)
+		{
+			++m_stats.peaksEmitted;
+
+			if (peaks.size() < peaks.capacity())
+			{
+				peaks.push_back(Peak(peak));
+				return;
+			}
+
+			uint64_t start = PeakProfiler::now();
+			peaks.push_back(Peak(peak));
+			m_stats.allocationNanoseconds += PeakProfiler::now() - start;
+			m_stats.bytesAllocated += peaks.capacity() * sizeof(Peak);
+		}
+
+		// Phases don't overlap. Time spent growing the results during a phase isn't counted as part of it.
+		uint64_t startPhase()
+		{
+			m_allocationMark = m_stats.allocationNanoseconds;
+			return PeakProfiler::now();
+		}
+
+		void endPhase(PeakStats::Phase phase, uint64_t start)
+		{
+			uint64_t elapsed = PeakProfiler::now() - start;
+			m_stats.phaseNanoseconds[phase] += elapsed - (m_stats.allocationNanoseconds - m_allocationMark);
+		}
+
+	private:
+		PeakStats& m_stats;
+		uint64_t m_allocationMark;
+	};
+
+	/**
+	 * The threshold state machine behind all of the peak finders, along with the running area. Samples are fed to it
+	 * in order, one at a time with step() or a block at a time with scan(), and since the state is just a few values
+	 * it can be copied, compared, and resumed part way through an input.
+	 */
+	class ThresholdScanner
+	{
+	public:
+		typedef enum StepResult
+		{
+			STEP_NONE = 0,
+			STEP_LEFT_TROUGH,  // The sample is below the threshold and became the left trough
+			STEP_RIGHT_TROUGH, // The sample became the right trough
+			STEP_PEAK          // The sample completed a peak, which is in foundPeak or was passed to the sink
+		} StepResult;
+
+		uint64_t index; // Index of the next sample
+		double prevY;   // Value of the previous sample
+
+		GraphPeak currentPeak;
+		GraphPeak foundPeak;
+		AreaPrefix prefix;
+		AreaPrefix leftPrefix;
+		AreaPrefix rightPrefix;
+
+		ThresholdScanner() { clear(); }
+
+		void clear()
+		{
+			index = 0;
+			prevY = (double)0.0;
+			currentPeak.clear();
+			foundPeak.clear();
+			prefix.clear();
+			leftPrefix.clear();
+			rightPrefix.clear();
+		}
+
+		/**
+		 * True if both scanners are at the same sample with the same partial peak, in which case they will find the
+		 * same peaks from here on.
+		 */
+		bool sameState(const ThresholdScanner& rhs) const;
+
+		/**
+		 * Processes the next sample, whose x value is normally the sample index.
+		 */
+		StepResult step(uint64_t x, double y, double threshold)
+		{
+			auto keepPeak = [this](const GraphPeak& peak, uint64_t) { foundPeak = peak; };
+			return step(x, y, threshold, keepPeak);
+		}
+
+		/**
+		 * Same as above, but a completed peak is passed to sink(peak, index) rather than being copied to foundPeak.
+		 * width is the distance from the previous sample, for the area.
+		 */
+		template <typename Sink>
+		StepResult step(uint64_t x, double y, double threshold, Sink& sink, double width = 1.0)
+		{
+			if (index > 0)
+				prefix.advance(index, prevY, y, width);
+			prevY = y;
+			++index;
+
+			if (y < threshold)
+			{
+				// Have we found a peak? If so, add it and start looking for the next one.
+				if (currentPeak.rightTrough.x > 0)
+				{
+					// Still descending
+					if (y <= currentPeak.rightTrough.y)
+					{
+						setRightTrough(x, y);
+						return STEP_RIGHT_TROUGH;
+					}
+
+					// Rising
+					completePeak(sink);
+					return STEP_PEAK;
+				}
+
+				// Are we looking for a left trough?
+				else if (currentPeak.leftTrough.x == 0)
+				{
+					setLeftTrough(x, y);
+					return STEP_LEFT_TROUGH;
+				}
+
+				// If we have a left trough and an existing peak, assume this is the right trough - for now.
+				else if ((currentPeak.peak.x > currentPeak.leftTrough.x) && (currentPeak.leftTrough.x > 0))
+				{
+					setRightTrough(x, y);
+					return STEP_RIGHT_TROUGH;
+				}
+
+				setLeftTrough(x, y);
+				return STEP_LEFT_TROUGH;
+			}
+			else if (currentPeak.leftTrough.x > 0) // Left trough is set.
+			{
+				// Are we looking for a peak or is this bigger than the current peak?
+				if (currentPeak.peak.x == 0 || y >= currentPeak.peak.y)
+				{
+					currentPeak.peak.x = x;
+					currentPeak.peak.y = y;
+				}
+			}
+			else if (currentPeak.rightTrough.x > 0) // Right trough is set.
+			{
+				completePeak(sink);
+				return STEP_PEAK;
+			}
+			else // Nothing is set, but the value is above the threshold.
+			{
+				setLeftTrough(x, y);
+			}
+			return STEP_NONE;
+		}
+
+		/**
+		 * Processes the next dataLen samples from the given reader, calling sink(peak, index) with each peak found and the
+		 * index of the sample that completed it. When a sample becomes a trough, the run of samples after it that would
+		 * only move that trough along (samples below the threshold while there's no peak, or samples that keep descending
+		 * below the threshold) is skipped with the reader's search and just added to the area.
+		 */
+		template <typename Reader, typename Sink>
+		void scan(const Reader& data, size_t dataLen, double threshold, Sink sink)
+		{
+			NoProfiling profiler;
+			scan(data, dataLen, threshold, sink, profiler);
+		}
+
+		/**
+		 * Same as above, also counting the samples and state transitions with the given profiling policy.
+		 */
+		template <typename Reader, typename Sink, typename Profiler>
+		void scan(const Reader& data, size_t dataLen, double threshold, Sink sink, Profiler& profiler)
+		{
+			ThresholdScanner local = *this; // Local copy, so the state stays in registers
+
+			profiler.scanned(dataLen);
+
+			for (size_t i = 0; i < dataLen; ++i)
+			{
+				StepResult result = local.step(data.x(i, local.index), data.y(i), threshold, sink, data.width(i));
+
+				if (result != STEP_NONE)
+					profiler.transition();
+
+				// Most runs in dense data are short, so don't bother with the search unless the next sample continues the run.
+				if ((result == STEP_LEFT_TROUGH || result == STEP_RIGHT_TROUGH) && (i + 1 < dataLen) && (data.y(i + 1) < threshold))
+				{
+					i = local.extendTrough(data, dataLen, i, threshold, result == STEP_RIGHT_TROUGH);
+				}
+			}
+			*this = local;
+		}
+
+	private:
+		void setLeftTrough(uint64_t x, double y)
+		{
+			currentPeak.leftTrough.x = x;
+			currentPeak.leftTrough.y = y;
+			leftPrefix = prefix;
+		}
+
+		void setRightTrough(uint64_t x, double y)
+		{
+			currentPeak.rightTrough.x = x;
+			currentPeak.rightTrough.y = y;
+			rightPrefix = prefix;
+		}
+
+		// Computes the area of the current peak from the prefix sums taken at its troughs, reports it, and starts looking for the next one.
+		template <typename Sink>
+		void completePeak(Sink& sink)
+		{
+			currentPeak.area = (double)0.0;
+			if (currentPeak.leftTrough.x < currentPeak.rightTrough.x)
+				currentPeak.area = leftPrefix.areaTo(rightPrefix);
+
+			sink(currentPeak, index - 1);
+			currentPeak.clear();
+		}
+
+		// Moves the trough just set at position i to the end of the run of samples after it. Returns the new position.
+		template <typename Reader>
+		size_t extendTrough(const Reader& data, size_t dataLen, size_t i, double threshold, bool descending)
+		{
+			size_t end = data.runEnd(i + 1, dataLen, threshold, descending);
+
+			if (end > i + 1)
+			{
+				AreaPrefix running = prefix; // Local copy, so the sum stays in registers
+				double y = prevY;
+				uint64_t runIndex = index;
+
+				for (size_t j = i + 1; j < end; ++j, ++runIndex)
+				{
+					double nextY = data.y(j);
+					running.advanceUnchecked(runIndex, y, nextY, data.width(j));
+					y = nextY;
+				}
+
+				// A NaN or infinite sample in the run: sum it again, leaving those out.
+				if (!running.isFinite())
+				{
+					running = prefix;
+					y = prevY;
+					runIndex = index;
+
+					for (size_t j = i + 1; j < end; ++j, ++runIndex)
+					{
+						double nextY = data.y(j);
+						running.advance(runIndex, y, nextY, data.width(j));
+						y = nextY;
+					}
+				}
+				index = runIndex;
+				prefix = running;
+				prevY = y;
+
+				if (descending)
+					setRightTrough(data.x(end - 1, index - 1), y);
+				else
+					setLeftTrough(data.x(end - 1, index - 1), y);
+				i = end - 1;
+			}
+			return i;
+		}
+	};
+
+	/**
+	 * Constraints for Peaks::findPeaksByProminence, after the arguments of the same names to scipy.signal.find_peaks.
+	 * The defaults keep every local maximum.
+	 */
+	class ProminenceOptions
+	{
+	public:
+		double minProminence;  // Minimum height of a peak above the higher of its two bases
+		size_t minDistance;    // Minimum number of samples between peaks; the higher of two peaks that are closer wins
+		double minWidth;       // Minimum width in samples, measured relHeight of the prominence below the peak
+		double relHeight;      // Where the width is measured, as a fraction of the prominence
+		bool rankByProminence; // Returns the most prominent peaks first instead of in order along the x axis
+
+		ProminenceOptions() { clear(); }
+
+		void clear()
+		{
+			minProminence = (double)0.0;
+			minDistance = 1;
+			minWidth = (double)0.0;
+			relHeight = (double)0.5;
+			rankByProminence = false;
+		}
+	};
 
 	/**
 	 * Collection of peak finding algorithms.
@@ -138,6 +721,7 @@ namespace Peaks
 		/**
 		 * Returns a list of all statistically significant peaks in the given waveform.
 		 * These are defined as peaks that rise more than one standard deviation above the mean for at least three points on the x axis.
+		 * For the array versions, numPeaks (if not NULL) is set to the number of peaks found.
 		 */
 		static GraphPeakList findPeaksOverThreshold(double* data, size_t dataLen, size_t* numPeaks, double threshold = 0.0);
 		static GraphPeakList findPeaksOverStd(double* data, size_t dataLen, size_t* numPeaks, double sigmas = 1.0);
@@ -146,22 +730,325 @@ namespace Peaks
 		static GraphPeakList findPeaksOverThreshold(const GraphLine& data, double threshold = 0.0);
 		static GraphPeakList findPeaksOverStd(const GraphLine& data, double sigmas = 1.0);
 
+		/**
+		 * Allocation-free versions for real-time use. The peaks are either written to a caller-provided buffer of maxPeaks
+		 * peaks, in which case numPeaks is set to the number found and false is returned if that's more than the buffer
+		 * holds, or they replace the contents of a list that is reused from call to call, in which case the number found
+		 * is returned.
+		 */
+		static bool findPeaksOverThreshold(const double* data, size_t dataLen, GraphPeak* peaks, size_t maxPeaks, size_t* numPeaks, double threshold = 0.0);
+		static bool findPeaksOverStd(const double* data, size_t dataLen, GraphPeak* peaks, size_t maxPeaks, size_t* numPeaks, double sigmas = 1.0);
+		static size_t findPeaksOverThreshold(const double* data, size_t dataLen, GraphPeakList& peaks, double threshold = 0.0);
+		static size_t findPeaksOverStd(const double* data, size_t dataLen, GraphPeakList& peaks, double sigmas = 1.0);
+#ifdef PEAKS_HAVE_PMR
+		static size_t findPeaksOverThreshold(const double* data, size_t dataLen, pmr::GraphPeakList& peaks, double threshold = 0.0);
+		static size_t findPeaksOverStd(const double* data, size_t dataLen, pmr::GraphPeakList& peaks, double sigmas = 1.0);
+#endif
+
+		/**
+		 * Same as above, but for samples of any arithmetic type (e.g., float data or int16_t ADC counts) that are read in
+		 * place, either from an array or from a strided column such as one member of an array of records.
+		 */
+		template <typename T>
+		static GraphPeakList findPeaksOverThreshold(const SampleView<T>& data, double threshold = 0.0)
+		{
+			ProfiledCall call;
+
+			if (data.contiguous())
+				return Peaks::scanOverThreshold(ArrayReader<T>(data.data()), data.size(), threshold);
+			return Peaks::scanOverThreshold(StridedReader<T>(data), data.size(), threshold);
+		}
+
+		template <typename T>
+		static GraphPeakList findPeaksOverStd(const SampleView<T>& data, double sigmas = 1.0)
+		{
+			ProfiledCall call;
+
+			if (data.contiguous())
+				return Peaks::scanOverStd(ArrayReader<T>(data.data()), data.size(), sigmas);
+			return Peaks::scanOverStd(StridedReader<T>(data), data.size(), sigmas);
+		}
+
+		/**
+		 * Compact versions of the above: the peaks replace the contents of a list of narrower peaks (e.g., a
+		 * CompactGraphPeakList) that is reused from call to call, and the number found is returned. The samples are still
+		 * compared and summed as doubles, so the peaks are the ones the other versions find, converted. Every sample
+		 * index has to fit in the peak's x type. The list can have any allocator (e.g., a pmr::CompactGraphPeakList).
+		 */
+		template <typename T, typename X, typename Y, typename Allocator>
+		static size_t findPeaksOverThreshold(const SampleView<T>& data, std::vector<BasicGraphPeak<X, Y>, Allocator>& peaks, double threshold = 0.0)
+		{
+			ProfiledCall call;
+
+			if (data.contiguous())
+				return Peaks::scanIntoList(ArrayReader<T>(data.data()), data.size(), threshold, peaks);
+			return Peaks::scanIntoList(StridedReader<T>(data), data.size(), threshold, peaks);
+		}
+
+		template <typename T, typename X, typename Y, typename Allocator>
+		static size_t findPeaksOverStd(const SampleView<T>& data, std::vector<BasicGraphPeak<X, Y>, Allocator>& peaks, double sigmas = 1.0)
+		{
+			ProfiledCall call;
+
+			if (data.contiguous())
+			{
+				ArrayReader<T> reader(data.data());
+				return Peaks::scanIntoList(reader, data.size(), Peaks::thresholdOverStd(reader, data.size(), sigmas), peaks);
+			}
+
+			StridedReader<T> reader(data);
+			return Peaks::scanIntoList(reader, data.size(), Peaks::thresholdOverStd(reader, data.size(), sigmas), peaks);
+		}
+
+		template <typename X, typename Y>
+		static size_t findPeaksOverThreshold(const BasicGraphLine<X, Y>& data, BasicGraphPeakList<X, Y>& peaks, double threshold = 0.0)
+		{
+			ProfiledCall call;
+			return Peaks::scanIntoList(BasicGraphLineReader<BasicGraphPoint<X, Y>>(data.data()), data.size(), threshold, peaks);
+		}
+
+		/**
+		 * Same as findPeaksOverThreshold, but the samples are smoothed with the given filter as they are scanned (see
+		 * Prefilter). The peaks, troughs and areas are those of the smoothed samples.
+		 */
+		static GraphPeakList findPeaksOverThreshold(const double* data, size_t dataLen, const Prefilter& filter, double threshold = 0.0);
+		static GraphPeakList findPeaksOverThreshold(const std::vector<double>& data, const Prefilter& filter, double threshold = 0.0);
+
+		template <typename T>
+		static GraphPeakList findPeaksOverThreshold(const SampleView<T>& data, const Prefilter& filter, double threshold = 0.0)
+		{
+			ProfiledCall call;
+
+			if (data.contiguous())
+				return Peaks::scanFiltered(ArrayReader<T>(data.data()), data.size(), filter, threshold);
+			return Peaks::scanFiltered(StridedReader<T>(data), data.size(), filter, threshold);
+		}
+
+		/**
+		 * Multi-channel versions. Each channel has its own threshold and gets its own list of peaks, returned in channel order.
+		 * Separate arrays of dataLen samples are processed concurrently on the given number of threads (zero for one per
+		 * hardware thread). An interleaved buffer of numFrames frames of frameLen values each (e.g., ts,x,y,z records) is
+		 * processed in a single pass over the frames, with each channel given as its column within the frame.
+		 */
+		static std::vector<GraphPeakList> findPeaksOverThreshold(const std::vector<const double*>& channels, size_t dataLen, const std::vector<double>& thresholds, size_t numThreads = 0);
+		static std::vector<GraphPeakList> findPeaksOverThresholdInterleaved(const double* frames, size_t numFrames, size_t frameLen, const std::vector<size_t>& columns, const std::vector<double>& thresholds);
+
+		/**
+		 * Same as findPeaksOverThreshold, but the data is split into chunks that are processed concurrently on the given
+		 * number of threads (zero for one per hardware thread). Peaks that straddle chunk boundaries are stitched back
+		 * together, so the result is identical to the serial version.
+		 */
+		static GraphPeakList findPeaksOverThresholdParallel(double* data, size_t dataLen, size_t* numPeaks, double threshold = 0.0, size_t numThreads = 0);
+		static GraphPeakList findPeaksOverThresholdParallel(const std::vector<double>& data, double threshold = 0.0, size_t numThreads = 0);
+
+		/**
+		 * Same as findPeaksOverStd, but the mean and standard deviation are computed together in a single pass
+		 * instead of one pass for each (VectorStats::meanAndVariance for arrays, Welford's method for graph lines).
+		 */
+		static GraphPeakList findPeaksOverStdSinglePass(double* data, size_t dataLen, size_t* numPeaks, double sigmas = 1.0);
+		static GraphPeakList findPeaksOverStdSinglePass(const std::vector<double>& data, double sigmas = 1.0);
+		static GraphPeakList findPeaksOverStdSinglePass(const GraphLine& data, double sigmas = 1.0);
+
+		/**
+		 * Returns the peaks that rise above an adaptive threshold: the given number of standard deviations above the mean
+		 * of the most recent windowSize samples. The data is only read once. See StreamingPeakFinder for use on live streams.
+		 */
+		static GraphPeakList findPeaksOverRollingStd(double* data, size_t dataLen, size_t* numPeaks, size_t windowSize, double sigmas = 1.0);
+		static GraphPeakList findPeaksOverRollingStd(const std::vector<double>& data, size_t windowSize, double sigmas = 1.0);
+
+		/**
+		 * Returns the local maxima in the given array, the way scipy.signal.find_peaks does: the left and right troughs
+		 * of each peak are its prominence bases, i.e. the lowest samples between it and the nearest higher sample on
+		 * either side (or the end of the data), and its prominence is its height above the higher of the two. The middle
+		 * sample of a flat top is the peak. Runs in O(n log n) with monotonic stacks, so the cost doesn't grow with the
+		 * distance between peaks and their bases.
+		 */
+		static GraphPeakList findPeaksByProminence(const double* data, size_t dataLen, const ProminenceOptions& options = ProminenceOptions());
+		static GraphPeakList findPeaksByProminence(const std::vector<double>& data, const ProminenceOptions& options = ProminenceOptions());
+
+		/**
+		 * Height of the peak above the higher of its troughs, which for the peaks above is its prominence.
+		 */
+		static double prominence(const GraphPeak& peak);
+
+		/**
+		 * Time-weighted versions for graph lines whose x values are unevenly spaced, such as jittery timestamps. Each
+		 * trapezoid in the area is as wide as the x distance between its points instead of one, and the points are tracked
+		 * by index during the scan, so repeated x values (or an x of zero) are handled. The x values of the troughs and the
+		 * peak are in the same units as the input, and so is duration(peak). The x values must not decrease.
+		 */
+		static GraphPeakList findPeaksOverThresholdTimeWeighted(const GraphLine& data, double threshold = 0.0);
+		static GraphPeakList findPeaksOverStdTimeWeighted(const GraphLine& data, double sigmas = 1.0);
+
+		/**
+		 * Distance along the x axis from the left trough to the right trough.
+		 */
+		static uint64_t duration(const GraphPeak& peak);
+
 	private:
-		static double average(const double* data, size_t numPoints);
-    	static double average(const std::vector<double>& data);
-		static double average(const GraphLine& data);
+		static double average(const ArrayReader<double>& data, size_t dataLen);
+		static double variance(const ArrayReader<double>& data, size_t dataLen, double mean);
+
+		template <typename Reader>
+		static double average(const Reader& data, size_t dataLen)
+		{
+			double sum = (double)0.0;
+
+			for (size_t i = 0; i < dataLen; ++i)
+				sum = sum + data.y(i);
+			return sum / (double)dataLen;
+		}
+
+		template <typename Reader>
+		static double variance(const Reader& data, size_t dataLen, double mean)
+		{
+			double numerator = (double)0.0;
+
+			for (size_t i = 0; i < dataLen; ++i)
+				numerator = numerator + ((data.y(i) - mean) * (data.y(i) - mean));
+			return numerator / (double)(dataLen - 1);
+		}
+
+		// The algorithm itself. All of the public functions for single inputs are wrappers around these. Each is instantiated
+		// with NoProfiling and, for when a PeakProfiler is collecting, with Profiling.
+		template <typename Reader>
+		static GraphPeakList scanOverThreshold(const Reader& data, size_t dataLen, double threshold)
+		{
+			PeakStats* stats = PeakProfiler::current();
+
+			if (stats)
+			{
+				Profiling profiler(*stats);
+				return Peaks::scanOverThreshold(data, dataLen, threshold, profiler);
+			}
+
+			NoProfiling profiler;
+			return Peaks::scanOverThreshold(data, dataLen, threshold, profiler);
+		}
+
+		template <typename Reader, typename Profiler>
+		static GraphPeakList scanOverThreshold(const Reader& data, size_t dataLen, double threshold, Profiler& profiler)
+		{
+			GraphPeakList peaks;
+			ThresholdScanner scanner;
+			uint64_t start = profiler.startPhase();
+
+			scanner.scan(data, dataLen, threshold, [&peaks, &profiler](const GraphPeak& peak, uint64_t) { profiler.append(peaks, peak); }, profiler);
+			profiler.endPhase(PeakStats::PHASE_SCAN, start);
+			return peaks;
+		}
+
+		template <typename Reader>
+		static bool scanIntoBuffer(const Reader& data, size_t dataLen, double threshold, GraphPeak* peaks, size_t maxPeaks, size_t* numPeaks)
+		{
+			PeakStats* stats = PeakProfiler::current();
+
+			if (stats)
+			{
+				Profiling profiler(*stats);
+				return Peaks::scanIntoBuffer(data, dataLen, threshold, peaks, maxPeaks, numPeaks, profiler);
+			}
+
+			NoProfiling profiler;
+			return Peaks::scanIntoBuffer(data, dataLen, threshold, peaks, maxPeaks, numPeaks, profiler);
+		}
+
+		template <typename Reader, typename Profiler>
+		static bool scanIntoBuffer(const Reader& data, size_t dataLen, double threshold, GraphPeak* peaks, size_t maxPeaks, size_t* numPeaks, Profiler& profiler)
+		{
+			ThresholdScanner scanner;
+			size_t count = 0;
+			uint64_t start = profiler.startPhase();
+
+			// Keep counting once the buffer is full so the caller knows how big it needs to be.
+			scanner.scan(data, dataLen, threshold, [peaks, maxPeaks, &count, &profiler](const GraphPeak& peak, uint64_t) {
+				if (count < maxPeaks)
+					peaks[count] = peak;
+				++count;
+				profiler.found();
+			}, profiler);
+			profiler.endPhase(PeakStats::PHASE_SCAN, start);
+
+			if (numPeaks)
+				*numPeaks = count;
+			return count <= maxPeaks;
+		}
+
+		template <typename Reader, typename Peak, typename Allocator>
+		static size_t scanIntoList(const Reader& data, size_t dataLen, double threshold, std::vector<Peak, Allocator>& peaks)
+		{
+			PeakStats* stats = PeakProfiler::current();
+
+			if (stats)
+			{
+				Profiling profiler(*stats);
+				return Peaks::scanIntoList(data, dataLen, threshold, peaks, profiler);
+			}
+
+			NoProfiling profiler;
+			return Peaks::scanIntoList(data, dataLen, threshold, peaks, profiler);
+		}
+
+		template <typename Reader, typename Peak, typename Allocator, typename Profiler>
+		static size_t scanIntoList(const Reader& data, size_t dataLen, double threshold, std::vector<Peak, Allocator>& peaks, Profiler& profiler)
+		{
+			ThresholdScanner scanner;
+			uint64_t start = profiler.startPhase();
+
+			peaks.clear();
+			scanner.scan(data, dataLen, threshold, [&peaks, &profiler](const GraphPeak& peak, uint64_t) { profiler.append(peaks, peak); }, profiler);
+			profiler.endPhase(PeakStats::PHASE_SCAN, start);
+			return peaks.size();
+		}
+
+		template <typename Reader>
+		static double thresholdOverStd(const Reader& data, size_t dataLen, double sigmas)
+		{
+			PeakStats* stats = PeakProfiler::current();
+			uint64_t start = stats ? PeakProfiler::now() : 0;
+
+			double mean = Peaks::average(data, dataLen);
+			double stddev = sigmas * sqrt(Peaks::variance(data, dataLen, mean));
+
+			if (stats)
+				stats->phaseNanoseconds[PeakStats::PHASE_STATS] += PeakProfiler::now() - start;
+			return mean + stddev;
+		}
+
+		template <typename Reader>
+		static GraphPeakList scanOverStd(const Reader& data, size_t dataLen, double sigmas)
+		{
+			return Peaks::scanOverThreshold(data, dataLen, Peaks::thresholdOverStd(data, dataLen, sigmas));
+		}
+
+		// Filters the samples a block at a time into a small buffer, and scans each block as soon as it has been filtered.
+		template <typename Reader>
+		static GraphPeakList scanFiltered(const Reader& data, size_t dataLen, const Prefilter& filter, double threshold)
+		{
+			GraphPeakList peaks;
+			Prefilter local = filter;
+			ThresholdScanner scanner;
+			std::vector<double> block(Prefilter::BLOCK_SIZE);
+			uint64_t start = PeakProfiler::current() ? PeakProfiler::now() : 0;
+
+			local.reset();
+			for (size_t from = 0; from < dataLen; from += Prefilter::BLOCK_SIZE)
+			{
+				size_t to = std::min(from + Prefilter::BLOCK_SIZE, dataLen);
+
+				local.apply(data, dataLen, from, to, block.data());
+				scanner.scan(ArrayReader<double>(block.data()), to - from, threshold, [&peaks](const GraphPeak& peak, uint64_t) { peaks.push_back(peak); });
+			}
+			Peaks::addListStats(peaks, dataLen, start);
+			return peaks;
+		}
 
-		static double variance(const double* data, size_t numPoints, double mean);
-		static double variance(const std::vector<double>& data, double mean);
-		static double variance(const GraphLine& data, double mean);
+		static void setNumPeaks(size_t* numPeaks, const GraphPeakList& peaks);
 
-		static double standardDeviation(const double* data, size_t numPoints, double mean);
-		static double standardDeviation(const std::vector<double>& data, double mean);
-		static double standardDeviation(const GraphLine& data, double mean);
+		static GraphPeakList scanTimeWeighted(const GraphLine& data, double threshold);
 
-		static void computeArea(double* data, size_t dataLen, GraphPeak& currentPeak);
-		static void computeArea(const std::vector<double>& data, GraphPeak& currentPeak);
-		static void computeArea(const GraphLine& data, GraphPeak& currentPeak);
+		static GraphPeakList findPeaksOverThresholdInChunks(const double* data, size_t dataLen, double threshold, size_t numThreads);
+		static void addListStats(const GraphPeakList& peaks, size_t numSamples, uint64_t start);
 	};
 }
 
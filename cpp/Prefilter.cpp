@@ -0,0 +1,387 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "Prefilter.h"
+
+#include <math.h>
+
+namespace Peaks
+{
+	// Rounds a window size up to an odd number, so the window can be centered on a sample.
+	static size_t oddWindowSize(size_t windowSize)
+	{
+		return windowSize | 1;
+	}
+
+	// The order the median window is kept in: NaNs after every other value, so that NaN samples can be sorted and found.
+	static bool medianBefore(double lhs, double rhs)
+	{
+		return (lhs < rhs) || (isnan(rhs) && !isnan(lhs));
+	}
+
+	// Number of samples in the sorted window that come before the value in the order above.
+	static size_t countBefore(const double* sorted, size_t windowSize, double value)
+	{
+		size_t count = 0;
+
+		if (isnan(value))
+		{
+			for (size_t k = 0; k < windowSize; ++k)
+				count += (sorted[k] == sorted[k]);
+		}
+		else
+		{
+			for (size_t k = 0; k < windowSize; ++k)
+				count += (sorted[k] < value);
+		}
+		return count;
+	}
+
+	static bool allFinite(const double* samples, size_t numSamples)
+	{
+		bool finite = true;
+
+		for (size_t i = 0; i < numSamples; ++i)
+			finite &= (bool)isfinite(samples[i]);
+		return finite;
+	}
+
+	// Average of the window, summed directly, for windows with NaN or infinite samples in them.
+	static double directAverage(const double* window, size_t windowSize)
+	{
+		double sum = (double)0.0;
+
+		for (size_t j = 0; j < windowSize; ++j)
+			sum += window[j];
+		return sum / (double)windowSize;
+	}
+
+	// Weights that give the value at the center of the least-squares polynomial of the given order through a window
+	// of samples at -half..half. That value is the projection of the samples onto the polynomials sampled at the
+	// offsets, so the weights are the projection of the center sample, taken with an orthonormal basis built by
+	// Gram-Schmidt (done twice for each polynomial, for accuracy). The offsets are scaled to [-1, 1], which doesn't
+	// change the weights, but keeps the powers from growing apart.
+	static std::vector<double> savitzkyGolayCoefficients(size_t half, size_t polyOrder)
+	{
+		size_t windowSize = 2 * half + 1;
+		double scale = (half > 0) ? (double)1.0 / (double)half : (double)1.0;
+		std::vector<std::vector<double>> basis;
+		std::vector<double> power(windowSize, (double)1.0);
+
+		for (size_t order = 0; order <= polyOrder; ++order)
+		{
+			std::vector<double> vector = power;
+
+			for (size_t pass = 0; pass < 2; ++pass)
+			{
+				for (auto iter = basis.begin(); iter != basis.end(); ++iter)
+				{
+					double dot = (double)0.0;
+					for (size_t j = 0; j < windowSize; ++j)
+						dot += vector[j] * (*iter)[j];
+					for (size_t j = 0; j < windowSize; ++j)
+						vector[j] -= dot * (*iter)[j];
+				}
+			}
+
+			double norm = (double)0.0;
+			for (size_t j = 0; j < windowSize; ++j)
+				norm += vector[j] * vector[j];
+			norm = sqrt(norm);
+
+			for (size_t j = 0; j < windowSize; ++j)
+				vector[j] /= norm;
+			basis.push_back(vector);
+
+			for (size_t j = 0; j < windowSize; ++j)
+				power[j] *= ((double)j - (double)half) * scale;
+		}
+
+		std::vector<double> coefficients(windowSize, (double)0.0);
+		for (auto iter = basis.begin(); iter != basis.end(); ++iter)
+		{
+			for (size_t j = 0; j < windowSize; ++j)
+				coefficients[j] += (*iter)[j] * (*iter)[half];
+		}
+		return coefficients;
+	}
+
+	Prefilter::Prefilter() :
+		m_type(FILTER_NONE),
+		m_windowSize(1),
+		m_alpha((double)1.0)
+	{
+		reset();
+	}
+
+	Prefilter Prefilter::movingAverage(size_t windowSize)
+	{
+		Prefilter filter;
+		filter.m_type = FILTER_MOVING_AVERAGE;
+		filter.m_windowSize = oddWindowSize(windowSize);
+		return filter;
+	}
+
+	Prefilter Prefilter::exponential(double alpha)
+	{
+		Prefilter filter;
+		filter.m_type = FILTER_EXPONENTIAL;
+		filter.m_alpha = std::min(std::max(alpha, (double)0.0), (double)1.0);
+		return filter;
+	}
+
+	Prefilter Prefilter::savitzkyGolay(size_t windowSize, size_t polyOrder)
+	{
+		Prefilter filter;
+		filter.m_type = FILTER_SAVITZKY_GOLAY;
+		filter.m_windowSize = oddWindowSize(windowSize);
+		filter.m_coefficients = savitzkyGolayCoefficients(filter.m_windowSize / 2, std::min(polyOrder, filter.m_windowSize - 1));
+		return filter;
+	}
+
+	Prefilter Prefilter::median(size_t windowSize)
+	{
+		Prefilter filter;
+		filter.m_type = FILTER_MEDIAN;
+		filter.m_windowSize = oddWindowSize(windowSize);
+		return filter;
+	}
+
+	bool Prefilter::parse(const std::string& spec, Prefilter& filter)
+	{
+		size_t colon = spec.find(':');
+		std::string name = spec.substr(0, colon);
+		std::string args = (colon == std::string::npos) ? "" : spec.substr(colon + 1);
+		const char* start = args.c_str();
+		char* end = NULL;
+
+		if (name == "none" && args.empty())
+		{
+			filter = Prefilter();
+			return true;
+		}
+		if (args.empty())
+			return false;
+
+		if (name == "ema")
+		{
+			double alpha = strtod(start, &end);
+			if (*end != '\0' || !(alpha > (double)0.0) || alpha > (double)1.0)
+				return false;
+			filter = exponential(alpha);
+			return true;
+		}
+
+		unsigned long windowSize = strtoul(start, &end, 10);
+		if (end == start || windowSize == 0)
+			return false;
+
+		if (name == "sg" && *end == ':')
+		{
+			start = end + 1;
+			unsigned long polyOrder = strtoul(start, &end, 10);
+			if (end == start || *end != '\0' || polyOrder >= oddWindowSize(windowSize))
+				return false;
+			filter = savitzkyGolay(windowSize, polyOrder);
+			return true;
+		}
+		if (*end != '\0')
+			return false;
+
+		if (name == "ma")
+		{
+			filter = movingAverage(windowSize);
+			return true;
+		}
+		if (name == "median")
+		{
+			filter = median(windowSize);
+			return true;
+		}
+		return false;
+	}
+
+	void Prefilter::reset()
+	{
+		m_average = (double)0.0;
+		m_started = false;
+	}
+
+	void Prefilter::smoothExponential(size_t numSamples, double* out)
+	{
+		double average = m_average;
+		size_t i = 0;
+
+		if (!m_started && numSamples > 0)
+		{
+			average = out[0];
+			m_started = true;
+			++i;
+		}
+		for (; i < numSamples; ++i)
+		{
+			average = average + m_alpha * (out[i] - average);
+			out[i] = average;
+		}
+		m_average = average;
+	}
+
+	// Filters the samples gathered in m_window, where output i is centered on m_window[i + half].
+	void Prefilter::filterWindow(size_t numSamples, double* out)
+	{
+		const double* window = m_window.data();
+
+		switch (m_type)
+		{
+		case FILTER_MOVING_AVERAGE:
+			// Blocks without NaN or infinite samples, which are checked for first, get the plain running sum.
+			if (allFinite(window, numSamples + m_windowSize - 1))
+			{
+				// A running sum, started afresh for each block so that rounding errors don't build up.
+				double scale = (double)1.0 / (double)m_windowSize;
+				double sum = (double)0.0;
+
+				for (size_t j = 0; j < m_windowSize; ++j)
+					sum += window[j];
+				out[0] = sum * scale;
+
+				for (size_t i = 1; i < numSamples; ++i)
+				{
+					sum += window[i + m_windowSize - 1] - window[i - 1];
+					out[i] = sum * scale;
+				}
+			}
+			else
+			{
+				// NaN and infinite samples are counted rather than added: while there are any in the window the output
+				// is summed directly, and the running sum is rebuilt once they have all left, so they only affect the
+				// outputs whose windows hold them.
+				double scale = (double)1.0 / (double)m_windowSize;
+				double sum = (double)0.0;
+				size_t numNonFinite = 0;
+
+				for (size_t j = 0; j < m_windowSize; ++j)
+				{
+					if (isfinite(window[j]))
+						sum += window[j];
+					else
+						++numNonFinite;
+				}
+
+				for (size_t i = 0; i < numSamples; ++i)
+				{
+					if (i > 0)
+					{
+						double leaving = window[i - 1];
+						double entering = window[i + m_windowSize - 1];
+
+						if ((numNonFinite == 0) && isfinite(entering))
+						{
+							sum += entering - leaving;
+						}
+						else
+						{
+							numNonFinite -= !isfinite(leaving);
+							numNonFinite += !isfinite(entering);
+
+							if (numNonFinite == 0)
+							{
+								sum = (double)0.0;
+								for (size_t j = i; j < i + m_windowSize; ++j)
+									sum += window[j];
+							}
+						}
+					}
+					out[i] = (numNonFinite == 0) ? (sum * scale) : directAverage(window + i, m_windowSize);
+				}
+			}
+			break;
+		case FILTER_SAVITZKY_GOLAY:
+			// One weight at a time across the whole block, which the compiler vectorizes.
+			for (size_t i = 0; i < numSamples; ++i)
+				out[i] = (double)0.0;
+			for (size_t j = 0; j < m_windowSize; ++j)
+			{
+				double weight = m_coefficients[j];
+				const double* shifted = window + j;
+
+				for (size_t i = 0; i < numSamples; ++i)
+					out[i] += weight * shifted[i];
+			}
+			break;
+		case FILTER_MEDIAN:
+			{
+				// The window is kept sorted as it slides. The positions of the sample leaving it and of the one entering
+				// it are counted rather than searched for, which avoids mispredicted branches, and only the samples
+				// between the two move.
+				size_t half = m_windowSize / 2;
+
+				m_sorted.assign(window, window + m_windowSize);
+				std::sort(m_sorted.begin(), m_sorted.end(), medianBefore);
+				out[0] = m_sorted[half];
+
+				double* sorted = m_sorted.data();
+				for (size_t i = 1; i < numSamples; ++i)
+				{
+					double leaving = window[i - 1];
+					double entering = window[i + m_windowSize - 1];
+					size_t leavingPos = 0;
+					size_t enteringPos = 0;
+
+					if (isnan(leaving) || isnan(entering))
+					{
+						leavingPos = countBefore(sorted, m_windowSize, leaving);
+						enteringPos = countBefore(sorted, m_windowSize, entering);
+					}
+					else
+					{
+						for (size_t k = 0; k < m_windowSize; ++k)
+						{
+							leavingPos += (sorted[k] < leaving);
+							enteringPos += (sorted[k] < entering);
+						}
+					}
+
+					// The leaving sample is always in the window, so this only guards the writes below.
+					if (leavingPos >= m_windowSize)
+						leavingPos = m_windowSize - 1;
+
+					if (enteringPos > leavingPos)
+					{
+						for (size_t k = leavingPos; k + 1 < enteringPos; ++k)
+							sorted[k] = sorted[k + 1];
+						sorted[enteringPos - 1] = entering;
+					}
+					else
+					{
+						for (size_t k = leavingPos; k > enteringPos; --k)
+							sorted[k] = sorted[k - 1];
+						sorted[enteringPos] = entering;
+					}
+					out[i] = sorted[half];
+				}
+			}
+			break;
+		default:
+			break;
+		}
+	}
+}
@@ -0,0 +1,134 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#ifndef _PREFILTER_
+#define _PREFILTER_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace Peaks
+{
+	typedef enum FilterType
+	{
+		FILTER_NONE = 0,
+		FILTER_MOVING_AVERAGE,
+		FILTER_EXPONENTIAL,
+		FILTER_SAVITZKY_GOLAY,
+		FILTER_MEDIAN
+	} FilterType;
+
+	/**
+	 * Smoothing for samples that are about to be scanned for peaks, so that noise doesn't show up as many tiny peaks.
+	 * The peak finders that take a filter apply it a block at a time just ahead of the scan, so the smoothed samples
+	 * are still in cache when they are scanned and no smoothed copy of the whole input is made.
+	 *
+	 * The moving average, Savitzky-Golay and median filters are centered on each sample, so peaks stay where they
+	 * are in the raw data. Samples beyond either end of the data are taken to repeat the sample at that end. Even
+	 * window sizes are rounded up to the next odd size. The exponential moving average is causal, so it lags the data.
+	 * The median treats NaN samples as higher than any other, so a lone NaN is filtered out.
+	 */
+	class Prefilter
+	{
+	public:
+		static const size_t BLOCK_SIZE = 2048; // Samples filtered at a time
+
+		Prefilter(); // No filtering
+
+		static Prefilter movingAverage(size_t windowSize);
+		static Prefilter exponential(double alpha);                            // 0 < alpha <= 1; higher follows faster
+		static Prefilter savitzkyGolay(size_t windowSize, size_t polyOrder);   // Least-squares polynomial fit over the window
+		static Prefilter median(size_t windowSize);                            // Best with small windows
+
+		/**
+		 * Parses a filter specification: none, ma:<window>, ema:<alpha>, sg:<window>:<order> or median:<window>.
+		 * Returns false if it isn't one of those.
+		 */
+		static bool parse(const std::string& spec, Prefilter& filter);
+
+		FilterType type() const { return m_type; }
+		size_t windowSize() const { return m_windowSize; }
+
+		/**
+		 * Forgets the exponential filter's average, so the next sample filtered starts it afresh.
+		 */
+		void reset();
+
+		/**
+		 * Writes the filtered values of samples [from, to) of the dataLen samples in the given reader (see ArrayReader) to
+		 * out. The exponential filter carries its average from one call to the next, so blocks have to be filtered in order.
+		 */
+		template <typename Reader>
+		void apply(const Reader& data, size_t dataLen, size_t from, size_t to, double* out)
+		{
+			size_t numSamples = to - from;
+			size_t half = m_windowSize / 2;
+
+			if (m_type == FILTER_NONE || m_type == FILTER_EXPONENTIAL)
+			{
+				for (size_t i = 0; i < numSamples; ++i)
+					out[i] = data.y(from + i);
+				if (m_type == FILTER_EXPONENTIAL)
+					smoothExponential(numSamples, out);
+				return;
+			}
+
+			// Gather the samples under the window for every sample in the block, repeating the end samples.
+			m_window.resize(numSamples + 2 * half);
+			if (from >= half && to + half <= dataLen)
+			{
+				for (size_t i = 0; i < m_window.size(); ++i)
+					m_window[i] = data.y(from - half + i);
+			}
+			else
+			{
+				for (size_t i = 0; i < m_window.size(); ++i)
+				{
+					size_t index = (from + i < half) ? 0 : std::min(from + i - half, dataLen - 1);
+					m_window[i] = data.y(index);
+				}
+			}
+			filterWindow(numSamples, out);
+		}
+
+	private:
+		FilterType m_type;
+		size_t m_windowSize;
+		double m_alpha;
+		std::vector<double> m_coefficients; // Savitzky-Golay weights, one per sample in the window
+
+		double m_average; // Exponential moving average so far
+		bool m_started;
+
+		std::vector<double> m_window; // Samples of the block being filtered, with half a window either side
+		std::vector<double> m_sorted; // Scratch for the median
+
+		void smoothExponential(size_t numSamples, double* out);
+		void filterWindow(size_t numSamples, double* out);
+	};
+}
+
+#endif
@@ -0,0 +1,313 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <numeric>
+
+#include "Peaks.h"
+#include "PeakStats.h"
+
+namespace Peaks
+{
+	static const size_t NO_SAMPLE = (size_t)-1;
+
+	// A sample, for the monotonic stacks. The index is NO_SAMPLE for an empty run.
+	struct StackPoint
+	{
+		size_t index;
+		double y;
+	};
+
+	// The lower of two points, with ties going to the nearer one.
+	static StackPoint lowerPoint(const StackPoint& farther, const StackPoint& nearer)
+	{
+		if (nearer.index == NO_SAMPLE)
+			return farther;
+		if (farther.index == NO_SAMPLE || nearer.y <= farther.y)
+			return nearer;
+		return farther;
+	}
+
+	// Samples that are higher than their neighbors, with the middle of a flat top standing for it. Same as scipy's
+	// _local_maxima_1d, including that the first and last samples are never peaks.
+	static void findLocalMaxima(const double* data, size_t dataLen, std::vector<size_t>& positions)
+	{
+		size_t i = 1;
+
+		while (i + 1 < dataLen)
+		{
+			if (data[i - 1] < data[i])
+			{
+				size_t ahead = i + 1;
+				while (ahead + 1 < dataLen && data[ahead] == data[i])
+					++ahead;
+
+				if (data[ahead] < data[i])
+				{
+					positions.push_back((i + ahead - 1) / 2);
+					i = ahead;
+				}
+			}
+			++i;
+		}
+	}
+
+	// Drops the lower of any two peaks that are less than minDistance samples apart, starting with the highest peak.
+	// Peaks of the same height are taken in order along the x axis.
+	static void selectByDistance(const double* data, std::vector<size_t>& positions, size_t minDistance)
+	{
+		size_t numPeaks = positions.size();
+		std::vector<std::pair<double, size_t>> order(numPeaks); // Sorting the heights in place is much faster than sorting indexes to them
+		std::vector<bool> keep(numPeaks, true);
+
+		for (size_t j = 0; j < numPeaks; ++j)
+			order[j] = std::make_pair(-data[positions[j]], j);
+		std::sort(order.begin(), order.end());
+
+		// Kept peaks are at least minDistance apart, so no sample is looked at more than twice.
+		for (auto iter = order.begin(); iter != order.end(); ++iter)
+		{
+			size_t peak = (*iter).second;
+			if (!keep[peak])
+				continue;
+
+			for (size_t j = peak; j > 0 && positions[peak] - positions[j - 1] < minDistance; --j)
+				keep[j - 1] = false;
+			for (size_t j = peak + 1; j < numPeaks && positions[j] - positions[peak] < minDistance; ++j)
+				keep[j] = false;
+		}
+
+		size_t numKept = 0;
+		for (size_t j = 0; j < numPeaks; ++j)
+		{
+			if (keep[j])
+				positions[numKept++] = positions[j];
+		}
+		positions.resize(numKept);
+	}
+
+	// Finds the base of each peak on one side: the lowest sample between the peak and the nearest higher sample on that
+	// side (or the end of the data), the nearest one if there's a tie, or the peak itself if nothing is lower.
+	//
+	// The samples are visited from the far end toward the peaks with a stack of the ones that are higher than all those
+	// visited since, so that once a sample is pushed, the entry below it is the nearest higher sample. Alongside each
+	// entry is the lowest sample after the entry below it, up to and including its own. A new sample merges those of
+	// the entries it pops into its own, so every sample is pushed and popped at most once.
+	static void findBases(const double* data, size_t dataLen, const std::vector<size_t>& positions, bool leftSide, std::vector<StackPoint>& bases)
+	{
+		std::vector<double> stack;        // Samples
+		std::vector<StackPoint> lowests;  // Lowest sample up to each of them
+		size_t numPeaks = positions.size();
+		size_t next = 0; // Peaks are reached in the same order as the samples
+
+		bases.resize(numPeaks);
+		for (size_t step = 0; step < dataLen && next < numPeaks; ++step)
+		{
+			size_t i = leftSide ? step : (dataLen - 1 - step);
+			double y = data[i];
+			StackPoint lowest = { i, y };
+
+			while (!stack.empty() && stack.back() <= y)
+			{
+				lowest = lowerPoint(lowests.back(), lowest);
+				stack.pop_back();
+				lowests.pop_back();
+			}
+
+			size_t peak = leftSide ? next : (numPeaks - 1 - next);
+			if (positions[peak] == i)
+			{
+				bases[peak] = lowest;
+				++next;
+			}
+
+			stack.push_back(y);
+			lowests.push_back(lowest);
+		}
+	}
+
+	// Finds where the line drops to each peak's reference height on one side, as an interpolated x value, the way scipy's
+	// peak_widths does: at the nearest sample no higher than the reference height, but not beyond the base.
+	//
+	// The stack holds the samples that are no higher than any visited since. The nearest sample at or below a height is
+	// always on it, and the stack is sorted, so it's found with a binary search.
+	static void findCrossings(const double* data, size_t dataLen, const std::vector<size_t>& positions, const std::vector<double>& heights, const std::vector<StackPoint>& bases, bool leftSide, std::vector<double>& crossings)
+	{
+		std::vector<StackPoint> stack;
+		size_t numPeaks = positions.size();
+		size_t next = 0;
+
+		crossings.resize(numPeaks);
+		for (size_t step = 0; step < dataLen && next < numPeaks; ++step)
+		{
+			size_t i = leftSide ? step : (dataLen - 1 - step);
+			StackPoint point = { i, data[i] };
+
+			while (!stack.empty() && stack.back().y > point.y)
+				stack.pop_back();
+			stack.push_back(point);
+
+			size_t peak = leftSide ? next : (numPeaks - 1 - next);
+			if (positions[peak] != i)
+				continue;
+			++next;
+
+			double height = heights[peak];
+			auto found = std::upper_bound(stack.begin(), stack.end(), height, [](double value, const StackPoint& entry) { return value < entry.y; });
+			size_t crossing = (found == stack.begin()) ? NO_SAMPLE : (found - 1)->index;
+
+			// The search stops at the base, which is what the stack entry would be past.
+			bool pastBase = (crossing == NO_SAMPLE) || (leftSide ? (crossing < bases[peak].index) : (crossing > bases[peak].index));
+			if (pastBase)
+				crossing = bases[peak].index;
+
+			double x = (double)crossing;
+			if (data[crossing] < height)
+			{
+				size_t inside = leftSide ? (crossing + 1) : (crossing - 1);
+				double fraction = (height - data[crossing]) / (data[inside] - data[crossing]);
+				x = leftSide ? (x + fraction) : (x - fraction);
+			}
+			crossings[peak] = x;
+		}
+	}
+
+	// Returns the local maxima in the given array that meet the constraints, with their prominence bases as troughs.
+	GraphPeakList Peaks::findPeaksByProminence(const double* data, size_t dataLen, const ProminenceOptions& options)
+	{
+		ProfiledCall call;
+
+		GraphPeakList peaks;
+		std::vector<size_t> positions;
+		uint64_t start = PeakProfiler::current() ? PeakProfiler::now() : 0;
+
+		findLocalMaxima(data, dataLen, positions);
+		if (options.minDistance > 1)
+			selectByDistance(data, positions, options.minDistance);
+
+		std::vector<StackPoint> leftBases;
+		std::vector<StackPoint> rightBases;
+		findBases(data, dataLen, positions, true, leftBases);
+		findBases(data, dataLen, positions, false, rightBases);
+
+		// Keep the peaks that are prominent enough, with the height to measure their width at.
+		std::vector<double> prominences;
+		std::vector<double> heights;
+		size_t numKept = 0;
+		for (size_t j = 0; j < positions.size(); ++j)
+		{
+			double y = data[positions[j]];
+			double peakProminence = y - std::max(leftBases[j].y, rightBases[j].y);
+
+			if (peakProminence >= options.minProminence)
+			{
+				positions[numKept] = positions[j];
+				leftBases[numKept] = leftBases[j];
+				rightBases[numKept] = rightBases[j];
+				prominences.push_back(peakProminence);
+				heights.push_back(y - peakProminence * options.relHeight);
+				++numKept;
+			}
+		}
+		positions.resize(numKept);
+
+		// Then the ones that are wide enough.
+		std::vector<bool> wideEnough(numKept, true);
+		if (options.minWidth > (double)0.0)
+		{
+			std::vector<double> leftCrossings;
+			std::vector<double> rightCrossings;
+			findCrossings(data, dataLen, positions, heights, leftBases, true, leftCrossings);
+			findCrossings(data, dataLen, positions, heights, rightBases, false, rightCrossings);
+
+			for (size_t j = 0; j < numKept; ++j)
+				wideEnough[j] = (rightCrossings[j] - leftCrossings[j]) >= options.minWidth;
+		}
+
+		// The areas come from the area prefix at each base, taken in one pass over the data.
+		std::vector<size_t> baseIndexes;
+		for (size_t j = 0; j < numKept; ++j)
+		{
+			if (wideEnough[j])
+			{
+				baseIndexes.push_back(leftBases[j].index);
+				baseIndexes.push_back(rightBases[j].index);
+			}
+		}
+		std::sort(baseIndexes.begin(), baseIndexes.end());
+		baseIndexes.erase(std::unique(baseIndexes.begin(), baseIndexes.end()), baseIndexes.end());
+
+		std::vector<AreaPrefix> basePrefixes(baseIndexes.size());
+		AreaPrefix prefix;
+		size_t i = 0;
+		for (size_t b = 0; b < baseIndexes.size(); ++b)
+		{
+			for (; i < baseIndexes[b]; ++i)
+				prefix.advance(i + 1, data[i], data[i + 1]);
+			basePrefixes[b] = prefix;
+		}
+
+		std::vector<double> keptProminences;
+		for (size_t j = 0; j < numKept; ++j)
+		{
+			if (!wideEnough[j])
+				continue;
+
+			size_t left = std::lower_bound(baseIndexes.begin(), baseIndexes.end(), leftBases[j].index) - baseIndexes.begin();
+			size_t right = std::lower_bound(baseIndexes.begin(), baseIndexes.end(), rightBases[j].index) - baseIndexes.begin();
+
+			GraphPeak peak;
+			peak.leftTrough = GraphPoint(leftBases[j].index, leftBases[j].y);
+			peak.peak = GraphPoint(positions[j], data[positions[j]]);
+			peak.rightTrough = GraphPoint(rightBases[j].index, rightBases[j].y);
+			peak.area = basePrefixes[left].areaTo(basePrefixes[right]);
+			peaks.push_back(peak);
+			keptProminences.push_back(prominences[j]);
+		}
+
+		if (options.rankByProminence)
+		{
+			std::vector<size_t> order(peaks.size());
+			std::iota(order.begin(), order.end(), 0);
+			std::stable_sort(order.begin(), order.end(), [&keptProminences](size_t a, size_t b) { return keptProminences[a] > keptProminences[b]; });
+
+			GraphPeakList ranked;
+			ranked.reserve(peaks.size());
+			for (auto iter = order.begin(); iter != order.end(); ++iter)
+				ranked.push_back(peaks[*iter]);
+			peaks.swap(ranked);
+		}
+
+		Peaks::addListStats(peaks, dataLen, start);
+		return peaks;
+	}
+
+	// Returns the local maxima in the given vector that meet the constraints, with their prominence bases as troughs.
+	GraphPeakList Peaks::findPeaksByProminence(const std::vector<double>& data, const ProminenceOptions& options)
+	{
+		return Peaks::findPeaksByProminence(data.data(), data.size(), options);
+	}
+
+	double Peaks::prominence(const GraphPeak& peak)
+	{
+		return peak.peak.y - std::max(peak.leftTrough.y, peak.rightTrough.y);
+	}
+}
@@ -0,0 +1,238 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "SampleFile.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+namespace Peaks
+{
+	static bool isLittleEndianHost()
+	{
+		uint16_t one = 1;
+		return *reinterpret_cast<const uint8_t*>(&one) == 1;
+	}
+
+	// Returns the text after the given key in a .npy header dictionary, or an empty string if the key isn't there.
+	static std::string npyValue(const std::string& header, const std::string& key)
+	{
+		size_t pos = header.find("'" + key + "'");
+		if (pos == std::string::npos)
+			return "";
+
+		pos = header.find(':', pos);
+		if (pos == std::string::npos)
+			return "";
+		return header.substr(pos + 1);
+	}
+
+	// Returns the size of the file, or false if it can't be opened.
+	static bool fileSize(const std::string& fileName, uint64_t& size)
+	{
+		std::ifstream infile(fileName, std::ios::binary | std::ios::ate);
+
+		if (!infile)
+			return false;
+		size = (uint64_t)infile.tellg();
+		return true;
+	}
+
+	SampleFile::SampleFile()
+	{
+		close();
+	}
+
+	void SampleFile::close()
+	{
+		m_file.close();
+		m_samples = NULL;
+		m_dataType = DATA_TYPE_FLOAT64;
+		m_layout = LAYOUT_INTERLEAVED;
+		m_numChannels = 0;
+		m_numSamples = 0;
+		m_dataOffset = 0;
+	}
+
+	bool SampleFile::parseDataType(const std::string& name, DataType& dataType)
+	{
+		if (name == "f64")
+			dataType = DATA_TYPE_FLOAT64;
+		else if (name == "f32")
+			dataType = DATA_TYPE_FLOAT32;
+		else
+			return false;
+		return true;
+	}
+
+	bool SampleFile::parseLayout(const std::string& name, Layout& layout)
+	{
+		if (name == "interleaved")
+			layout = LAYOUT_INTERLEAVED;
+		else if (name == "planar")
+			layout = LAYOUT_PLANAR;
+		else
+			return false;
+		return true;
+	}
+
+	bool SampleFile::fail(const std::string& error)
+	{
+		close();
+		m_error = error;
+		return false;
+	}
+
+	// Points at the samples, which start at the given offset into the file.
+	bool SampleFile::setSamples(size_t offset, DataType dataType, size_t numChannels, size_t numSamples, Layout layout)
+	{
+		if (!isLittleEndianHost())
+			return fail("only little-endian hosts are supported");
+
+		m_samples = m_file.isOpen() ? (m_file.data() + offset) : NULL;
+		m_dataOffset = offset;
+		m_dataType = dataType;
+		m_layout = layout;
+		m_numChannels = numChannels;
+		m_numSamples = numSamples;
+		m_error.clear();
+		return true;
+	}
+
+	bool SampleFile::openRaw(const std::string& fileName, DataType dataType, size_t numChannels, Layout layout, bool mapSamples)
+	{
+		uint64_t size = 0;
+
+		close();
+
+		if (mapSamples ? !m_file.open(fileName) : !fileSize(fileName, size))
+			return fail("cannot read " + fileName);
+		if (mapSamples)
+			size = m_file.size();
+		if (numChannels == 0)
+			return fail("there must be at least one channel");
+
+		size_t frameSize = sampleSize(dataType) * numChannels;
+		if (size % frameSize != 0)
+			return fail(fileName + " is not a whole number of samples for every channel");
+		return setSamples(0, dataType, numChannels, (size_t)(size / frameSize), layout);
+	}
+
+	bool SampleFile::openNpy(const std::string& fileName, bool mapSamples)
+	{
+		const char MAGIC[] = "\x93NUMPY";
+		const size_t MAGIC_LEN = 6;
+		const size_t MAX_HEADER_LEN = 65536; // Only read this much of the file when it isn't mapped
+
+		std::vector<char> buffer;
+		const uint8_t* bytes;
+		uint64_t size = 0;
+
+		close();
+
+		if (mapSamples)
+		{
+			if (!m_file.open(fileName))
+				return fail("cannot read " + fileName);
+			bytes = reinterpret_cast<const uint8_t*>(m_file.data());
+			size = m_file.size();
+		}
+		else
+		{
+			std::ifstream infile(fileName, std::ios::binary);
+
+			if (!fileSize(fileName, size) || !infile)
+				return fail("cannot read " + fileName);
+			buffer.resize((size_t)std::min(size, (uint64_t)MAX_HEADER_LEN));
+			infile.read(buffer.data(), buffer.size());
+			bytes = reinterpret_cast<const uint8_t*>(buffer.data());
+		}
+		size_t available = mapSamples ? (size_t)size : buffer.size();
+
+		if ((available < 10) || (memcmp(bytes, MAGIC, MAGIC_LEN) != 0))
+			return fail(fileName + " is not a .npy file");
+
+		// Version 1 has a two byte header length, later versions four.
+		size_t headerStart = (bytes[6] == 1) ? 10 : 12;
+		size_t headerLen = bytes[8] | (bytes[9] << 8);
+		if (bytes[6] != 1)
+		{
+			if (available < 12)
+				return fail(fileName + " is not a .npy file");
+			headerLen |= ((size_t)bytes[10] << 16) | ((size_t)bytes[11] << 24);
+		}
+		if (headerStart + headerLen > available)
+			return fail(fileName + " has a truncated or oversized header");
+
+		std::string header(reinterpret_cast<const char*>(bytes) + headerStart, headerLen);
+		std::string descr = npyValue(header, "descr");
+		std::string fortranOrder = npyValue(header, "fortran_order");
+		std::string shape = npyValue(header, "shape");
+
+		DataType dataType;
+		descr.erase(0, descr.find_first_not_of(' '));
+		if (descr.compare(0, 5, "'<f8'") == 0)
+			dataType = DATA_TYPE_FLOAT64;
+		else if (descr.compare(0, 5, "'<f4'") == 0)
+			dataType = DATA_TYPE_FLOAT32;
+		else
+			return fail(fileName + " must hold little-endian float64 or float32 values");
+
+		// The dimensions are listed between the parentheses of the shape tuple.
+		std::vector<size_t> dims;
+		size_t openParen = shape.find('(');
+		size_t closeParen = shape.find(')');
+		if ((openParen == std::string::npos) || (closeParen == std::string::npos) || (closeParen < openParen))
+			return fail(fileName + " has no shape");
+		for (size_t pos = openParen + 1; pos < closeParen; )
+		{
+			char* end;
+			unsigned long long dim = strtoull(shape.c_str() + pos, &end, 10);
+			size_t next = end - shape.c_str();
+
+			if (next == pos)
+			{
+				++pos;
+				continue;
+			}
+			dims.push_back((size_t)dim);
+			pos = next;
+		}
+		if ((dims.size() < 1) || (dims.size() > 2))
+			return fail(fileName + " must have one or two dimensions");
+
+		size_t numChannels = (dims.size() == 2) ? dims[1] : 1;
+		if (numChannels == 0)
+			return fail(fileName + " has no channels");
+
+		Layout layout = (fortranOrder.find("True") != std::string::npos) ? LAYOUT_PLANAR : LAYOUT_INTERLEAVED;
+		uint64_t dataLen = (uint64_t)dims[0] * numChannels * sampleSize(dataType);
+
+		// Ignore anything after the array rather than taking it for more samples.
+		if (headerStart + headerLen + dataLen > size)
+			return fail(fileName + " is shorter than its shape");
+		return setSamples(headerStart + headerLen, dataType, numChannels, dims[0], layout);
+	}
+}
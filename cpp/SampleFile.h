@@ -0,0 +1,116 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#ifndef _SAMPLEFILE_
+#define _SAMPLEFILE_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+
+#include "MappedFile.h"
+#include "SampleView.h"
+
+namespace Peaks
+{
+	/**
+	 * Memory mapped file of binary samples, either a raw little-endian array or a NumPy .npy file. Each channel is
+	 * available as a SampleView straight into the mapping, so nothing is parsed or copied.
+	 *
+	 * Samples from several channels are either interleaved (one frame of numChannels values per sample, which is how a
+	 * C order .npy array of shape (numSamples, numChannels) is stored) or planar (all of the first channel, then all of
+	 * the second, and so on, as for a Fortran order array).
+	 */
+	class SampleFile
+	{
+	public:
+		typedef enum DataType
+		{
+			DATA_TYPE_FLOAT64 = 0,
+			DATA_TYPE_FLOAT32
+		} DataType;
+
+		typedef enum Layout
+		{
+			LAYOUT_INTERLEAVED = 0,
+			LAYOUT_PLANAR
+		} Layout;
+
+		SampleFile();
+
+		/**
+		 * Opens a raw array. Fails if the file size isn't a whole number of frames. On failure, error() says why.
+		 * If mapSamples is false, the file is only examined, so the layout is known but channel() can't be used;
+		 * this is for reading the samples some other way, starting at dataOffset().
+		 */
+		bool openRaw(const std::string& fileName, DataType dataType, size_t numChannels, Layout layout, bool mapSamples = true);
+
+		/**
+		 * Opens a .npy file of little-endian float64 or float32 values with one or two dimensions, the first being the
+		 * sample index and the second, if there is one, the channel.
+		 */
+		bool openNpy(const std::string& fileName, bool mapSamples = true);
+
+		void close();
+
+		DataType dataType() const { return m_dataType; }
+		Layout layout() const { return m_layout; }
+		size_t numChannels() const { return m_numChannels; }
+		size_t numSamples() const { return m_numSamples; }
+		uint64_t dataOffset() const { return m_dataOffset; } // Offset of the first sample in the file
+		const std::string& error() const { return m_error; }
+
+		static size_t sampleSize(DataType dataType) { return (dataType == DATA_TYPE_FLOAT32) ? sizeof(float) : sizeof(double); }
+		static bool parseDataType(const std::string& name, DataType& dataType); // "f64" or "f32"
+		static bool parseLayout(const std::string& name, Layout& layout);       // "interleaved" or "planar"
+
+		/**
+		 * The samples of one channel. T must be the type given by dataType().
+		 */
+		template <typename T>
+		SampleView<T> channel(size_t index) const
+		{
+			const T* samples = reinterpret_cast<const T*>(m_samples);
+
+			if (m_layout == LAYOUT_INTERLEAVED)
+				return SampleView<T>(samples + index, m_numSamples, m_numChannels * sizeof(T));
+			return SampleView<T>(samples + (index * m_numSamples), m_numSamples);
+		}
+
+	private:
+		MappedFile m_file;
+		const char* m_samples;
+		DataType m_dataType;
+		Layout m_layout;
+		size_t m_numChannels;
+		size_t m_numSamples;
+		uint64_t m_dataOffset;
+		std::string m_error;
+
+		bool setSamples(size_t offset, DataType dataType, size_t numChannels, size_t numSamples, Layout layout);
+		bool fail(const std::string& error);
+	};
+}
+
+#endif
@@ -0,0 +1,79 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#ifndef _SAMPLEVIEW_
+#define _SAMPLEVIEW_
+
+#include <stddef.h>
+#include <type_traits>
+
+namespace Peaks
+{
+	/**
+	 * Read-only view of samples of any arithmetic type that are stored somewhere else, either back to back or a fixed
+	 * number of bytes apart (e.g., one column of an array of records). Nothing is copied; samples are converted to
+	 * double as they are read.
+	 */
+	template <typename T>
+	class SampleView
+	{
+		static_assert(std::is_arithmetic<T>::value, "SampleView requires an arithmetic sample type");
+
+	public:
+		SampleView(const T* data, size_t length) : m_data(data), m_length(length), m_stride(sizeof(T)) {}
+		SampleView(const T* data, size_t length, size_t strideBytes) : m_data(data), m_length(length), m_stride(strideBytes) {}
+
+		const T* data() const { return m_data; }
+		size_t size() const { return m_length; }
+		size_t stride() const { return m_stride; } // In bytes
+		bool contiguous() const { return m_stride == sizeof(T); }
+
+		T operator[](size_t index) const
+		{
+			return *reinterpret_cast<const T*>(reinterpret_cast<const char*>(m_data) + (index * m_stride));
+		}
+
+	private:
+		const T* m_data;
+		size_t m_length;
+		size_t m_stride;
+	};
+
+	/**
+	 * Convenience constructors: a view of an array, and a view of one member of each element of an array of records.
+	 */
+	template <typename T>
+	SampleView<T> makeSampleView(const T* data, size_t length)
+	{
+		return SampleView<T>(data, length);
+	}
+
+	template <typename Record, typename T>
+	SampleView<T> makeSampleView(const Record* records, size_t numRecords, T Record::*member)
+	{
+		return SampleView<T>(&(records->*member), numRecords, sizeof(Record));
+	}
+}
+
+#endif
@@ -0,0 +1,555 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Statistics.h"
+
+#include <atomic>
+#include <math.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define PEAKS_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace Peaks
+{
+	double RunningStats::variance() const
+	{
+		if (m_count < 2)
+			return (double)0.0;
+		return m_m2 / (double)(m_count - 1);
+	}
+
+	double RunningStats::standardDeviation() const
+	{
+		return sqrt(variance());
+	}
+
+	RollingStats::RollingStats(size_t windowSize) :
+		m_window(windowSize)
+	{
+		clear();
+	}
+
+	void RollingStats::clear()
+	{
+		m_next = 0;
+		m_count = 0;
+		m_sinceRecompute = 0;
+		m_mean = (double)0.0;
+		m_m2 = (double)0.0;
+	}
+
+	void RollingStats::push(double y)
+	{
+		size_t windowSize = m_window.size();
+
+		if (windowSize == 0)
+			return;
+
+		// Still filling the window.
+		if (m_count < windowSize)
+		{
+			++m_count;
+			double delta = y - m_mean;
+			m_mean = m_mean + (delta / (double)m_count);
+			m_m2 = m_m2 + (delta * (y - m_mean));
+		}
+
+		// Replace the oldest sample.
+		else
+		{
+			double oldY = m_window[m_next];
+			double oldMean = m_mean;
+			m_mean = oldMean + ((y - oldY) / (double)windowSize);
+			m_m2 = m_m2 + ((y - oldY) * ((y - m_mean) + (oldY - oldMean)));
+		}
+
+		m_window[m_next] = y;
+		m_next = (m_next + 1 == windowSize) ? 0 : m_next + 1;
+
+		if (++m_sinceRecompute >= windowSize)
+			recompute();
+	}
+
+	// Recomputes the moments from the samples in the window.
+	void RollingStats::recompute()
+	{
+		double sum = (double)0.0;
+		for (size_t i = 0; i < m_count; ++i)
+			sum = sum + m_window[i];
+		m_mean = sum / (double)m_count;
+
+		double numerator = (double)0.0;
+		for (size_t i = 0; i < m_count; ++i)
+			numerator = numerator + ((m_window[i] - m_mean) * (m_window[i] - m_mean));
+		m_m2 = numerator;
+
+		m_sinceRecompute = 0;
+	}
+
+	double RollingStats::variance() const
+	{
+		if (m_count < 2 || m_m2 <= (double)0.0)
+			return (double)0.0;
+		return m_m2 / (double)(m_count - 1);
+	}
+
+	double RollingStats::standardDeviation() const
+	{
+		return sqrt(variance());
+	}
+
+	//
+	// Portable kernels. Four independent accumulators break the loop-carried dependency on the adder.
+	//
+
+	static double sumScalar(const double* data, size_t numPoints)
+	{
+		double s0 = (double)0.0, s1 = (double)0.0, s2 = (double)0.0, s3 = (double)0.0;
+		size_t index = 0;
+
+		for (; index + 4 <= numPoints; index += 4)
+		{
+			s0 = s0 + data[index];
+			s1 = s1 + data[index + 1];
+			s2 = s2 + data[index + 2];
+			s3 = s3 + data[index + 3];
+		}
+		for (; index < numPoints; ++index)
+			s0 = s0 + data[index];
+		return (s0 + s1) + (s2 + s3);
+	}
+
+	static double sumOfSquaredDeviationsScalar(const double* data, size_t numPoints, double mean)
+	{
+		double s0 = (double)0.0, s1 = (double)0.0, s2 = (double)0.0, s3 = (double)0.0;
+		size_t index = 0;
+
+		for (; index + 4 <= numPoints; index += 4)
+		{
+			double d0 = data[index] - mean;
+			double d1 = data[index + 1] - mean;
+			double d2 = data[index + 2] - mean;
+			double d3 = data[index + 3] - mean;
+			s0 = s0 + (d0 * d0);
+			s1 = s1 + (d1 * d1);
+			s2 = s2 + (d2 * d2);
+			s3 = s3 + (d3 * d3);
+		}
+		for (; index < numPoints; ++index)
+		{
+			double d = data[index] - mean;
+			s0 = s0 + (d * d);
+		}
+		return (s0 + s1) + (s2 + s3);
+	}
+
+	// Sum of (data[i] - shift) and of (data[i] - shift)^2.
+	static void shiftedSumsScalar(const double* data, size_t numPoints, double shift, double& sum, double& sumSq)
+	{
+		double s0 = (double)0.0, s1 = (double)0.0, q0 = (double)0.0, q1 = (double)0.0;
+		size_t index = 0;
+
+		for (; index + 2 <= numPoints; index += 2)
+		{
+			double d0 = data[index] - shift;
+			double d1 = data[index + 1] - shift;
+			s0 = s0 + d0;
+			s1 = s1 + d1;
+			q0 = q0 + (d0 * d0);
+			q1 = q1 + (d1 * d1);
+		}
+		for (; index < numPoints; ++index)
+		{
+			double d = data[index] - shift;
+			s0 = s0 + d;
+			q0 = q0 + (d * d);
+		}
+		sum = s0 + s1;
+		sumSq = q0 + q1;
+	}
+
+#ifdef PEAKS_X86_KERNELS
+	//
+	// SSE2 kernels: four registers of two lanes each.
+	//
+
+	__attribute__((target("sse2")))
+	static double horizontalSum(__m128d v)
+	{
+		__m128d high = _mm_unpackhi_pd(v, v);
+		return _mm_cvtsd_f64(_mm_add_sd(v, high));
+	}
+
+	__attribute__((target("sse2")))
+	static double sumSse2(const double* data, size_t numPoints)
+	{
+		__m128d a0 = _mm_setzero_pd(), a1 = _mm_setzero_pd(), a2 = _mm_setzero_pd(), a3 = _mm_setzero_pd();
+		size_t index = 0;
+
+		for (; index + 8 <= numPoints; index += 8)
+		{
+			a0 = _mm_add_pd(a0, _mm_loadu_pd(data + index));
+			a1 = _mm_add_pd(a1, _mm_loadu_pd(data + index + 2));
+			a2 = _mm_add_pd(a2, _mm_loadu_pd(data + index + 4));
+			a3 = _mm_add_pd(a3, _mm_loadu_pd(data + index + 6));
+		}
+		double total = horizontalSum(_mm_add_pd(_mm_add_pd(a0, a1), _mm_add_pd(a2, a3)));
+		return total + sumScalar(data + index, numPoints - index);
+	}
+
+	__attribute__((target("sse2")))
+	static double sumOfSquaredDeviationsSse2(const double* data, size_t numPoints, double mean)
+	{
+		__m128d m = _mm_set1_pd(mean);
+		__m128d a0 = _mm_setzero_pd(), a1 = _mm_setzero_pd(), a2 = _mm_setzero_pd(), a3 = _mm_setzero_pd();
+		size_t index = 0;
+
+		for (; index + 8 <= numPoints; index += 8)
+		{
+			__m128d d0 = _mm_sub_pd(_mm_loadu_pd(data + index), m);
+			__m128d d1 = _mm_sub_pd(_mm_loadu_pd(data + index + 2), m);
+			__m128d d2 = _mm_sub_pd(_mm_loadu_pd(data + index + 4), m);
+			__m128d d3 = _mm_sub_pd(_mm_loadu_pd(data + index + 6), m);
+			a0 = _mm_add_pd(a0, _mm_mul_pd(d0, d0));
+			a1 = _mm_add_pd(a1, _mm_mul_pd(d1, d1));
+			a2 = _mm_add_pd(a2, _mm_mul_pd(d2, d2));
+			a3 = _mm_add_pd(a3, _mm_mul_pd(d3, d3));
+		}
+		double total = horizontalSum(_mm_add_pd(_mm_add_pd(a0, a1), _mm_add_pd(a2, a3)));
+		return total + sumOfSquaredDeviationsScalar(data + index, numPoints - index, mean);
+	}
+
+	__attribute__((target("sse2")))
+	static void shiftedSumsSse2(const double* data, size_t numPoints, double shift, double& sum, double& sumSq)
+	{
+		__m128d k = _mm_set1_pd(shift);
+		__m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd(), q0 = _mm_setzero_pd(), q1 = _mm_setzero_pd();
+		size_t index = 0;
+
+		for (; index + 4 <= numPoints; index += 4)
+		{
+			__m128d d0 = _mm_sub_pd(_mm_loadu_pd(data + index), k);
+			__m128d d1 = _mm_sub_pd(_mm_loadu_pd(data + index + 2), k);
+			s0 = _mm_add_pd(s0, d0);
+			s1 = _mm_add_pd(s1, d1);
+			q0 = _mm_add_pd(q0, _mm_mul_pd(d0, d0));
+			q1 = _mm_add_pd(q1, _mm_mul_pd(d1, d1));
+		}
+
+		double tailSum, tailSumSq;
+		shiftedSumsScalar(data + index, numPoints - index, shift, tailSum, tailSumSq);
+		sum = horizontalSum(_mm_add_pd(s0, s1)) + tailSum;
+		sumSq = horizontalSum(_mm_add_pd(q0, q1)) + tailSumSq;
+	}
+
+	//
+	// AVX2 kernels: four registers of four lanes each.
+	//
+
+	__attribute__((target("avx2")))
+	static double horizontalSum(__m256d v)
+	{
+		__m128d low = _mm256_castpd256_pd128(v);
+		__m128d high = _mm256_extractf128_pd(v, 1);
+		low = _mm_add_pd(low, high);
+		__m128d swapped = _mm_unpackhi_pd(low, low);
+		return _mm_cvtsd_f64(_mm_add_sd(low, swapped));
+	}
+
+	__attribute__((target("avx2")))
+	static double sumAvx2(const double* data, size_t numPoints)
+	{
+		__m256d a0 = _mm256_setzero_pd(), a1 = _mm256_setzero_pd(), a2 = _mm256_setzero_pd(), a3 = _mm256_setzero_pd();
+		size_t index = 0;
+
+		for (; index + 16 <= numPoints; index += 16)
+		{
+			a0 = _mm256_add_pd(a0, _mm256_loadu_pd(data + index));
+			a1 = _mm256_add_pd(a1, _mm256_loadu_pd(data + index + 4));
+			a2 = _mm256_add_pd(a2, _mm256_loadu_pd(data + index + 8));
+			a3 = _mm256_add_pd(a3, _mm256_loadu_pd(data + index + 12));
+		}
+		double total = horizontalSum(_mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3)));
+		return total + sumScalar(data + index, numPoints - index);
+	}
+
+	__attribute__((target("avx2")))
+	static double sumOfSquaredDeviationsAvx2(const double* data, size_t numPoints, double mean)
+	{
+		__m256d m = _mm256_set1_pd(mean);
+		__m256d a0 = _mm256_setzero_pd(), a1 = _mm256_setzero_pd(), a2 = _mm256_setzero_pd(), a3 = _mm256_setzero_pd();
+		size_t index = 0;
+
+		for (; index + 16 <= numPoints; index += 16)
+		{
+			__m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(data + index), m);
+			__m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(data + index + 4), m);
+			__m256d d2 = _mm256_sub_pd(_mm256_loadu_pd(data + index + 8), m);
+			__m256d d3 = _mm256_sub_pd(_mm256_loadu_pd(data + index + 12), m);
+			a0 = _mm256_add_pd(a0, _mm256_mul_pd(d0, d0));
+			a1 = _mm256_add_pd(a1, _mm256_mul_pd(d1, d1));
+			a2 = _mm256_add_pd(a2, _mm256_mul_pd(d2, d2));
+			a3 = _mm256_add_pd(a3, _mm256_mul_pd(d3, d3));
+		}
+		double total = horizontalSum(_mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3)));
+		return total + sumOfSquaredDeviationsScalar(data + index, numPoints - index, mean);
+	}
+
+	__attribute__((target("avx2")))
+	static void shiftedSumsAvx2(const double* data, size_t numPoints, double shift, double& sum, double& sumSq)
+	{
+		__m256d k = _mm256_set1_pd(shift);
+		__m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd(), q0 = _mm256_setzero_pd(), q1 = _mm256_setzero_pd();
+		size_t index = 0;
+
+		for (; index + 8 <= numPoints; index += 8)
+		{
+			__m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(data + index), k);
+			__m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(data + index + 4), k);
+			s0 = _mm256_add_pd(s0, d0);
+			s1 = _mm256_add_pd(s1, d1);
+			q0 = _mm256_add_pd(q0, _mm256_mul_pd(d0, d0));
+			q1 = _mm256_add_pd(q1, _mm256_mul_pd(d1, d1));
+		}
+
+		double tailSum, tailSumSq;
+		shiftedSumsScalar(data + index, numPoints - index, shift, tailSum, tailSumSq);
+		sum = horizontalSum(_mm256_add_pd(s0, s1)) + tailSum;
+		sumSq = horizontalSum(_mm256_add_pd(q0, q1)) + tailSumSq;
+	}
+
+	//
+	// AVX-512 kernels: four registers of eight lanes each.
+	//
+
+	__attribute__((target("avx512f")))
+	static double horizontalSum(__m512d v)
+	{
+		double lanes[8];
+		_mm512_storeu_pd(lanes, v);
+		return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+	}
+
+	__attribute__((target("avx512f")))
+	static double sumAvx512(const double* data, size_t numPoints)
+	{
+		__m512d a0 = _mm512_setzero_pd(), a1 = _mm512_setzero_pd(), a2 = _mm512_setzero_pd(), a3 = _mm512_setzero_pd();
+		size_t index = 0;
+
+		for (; index + 32 <= numPoints; index += 32)
+		{
+			a0 = _mm512_add_pd(a0, _mm512_loadu_pd(data + index));
+			a1 = _mm512_add_pd(a1, _mm512_loadu_pd(data + index + 8));
+			a2 = _mm512_add_pd(a2, _mm512_loadu_pd(data + index + 16));
+			a3 = _mm512_add_pd(a3, _mm512_loadu_pd(data + index + 24));
+		}
+		double total = horizontalSum(_mm512_add_pd(_mm512_add_pd(a0, a1), _mm512_add_pd(a2, a3)));
+		return total + sumScalar(data + index, numPoints - index);
+	}
+
+	__attribute__((target("avx512f")))
+	static double sumOfSquaredDeviationsAvx512(const double* data, size_t numPoints, double mean)
+	{
+		__m512d m = _mm512_set1_pd(mean);
+		__m512d a0 = _mm512_setzero_pd(), a1 = _mm512_setzero_pd(), a2 = _mm512_setzero_pd(), a3 = _mm512_setzero_pd();
+		size_t index = 0;
+
+		for (; index + 32 <= numPoints; index += 32)
+		{
+			__m512d d0 = _mm512_sub_pd(_mm512_loadu_pd(data + index), m);
+			__m512d d1 = _mm512_sub_pd(_mm512_loadu_pd(data + index + 8), m);
+			__m512d d2 = _mm512_sub_pd(_mm512_loadu_pd(data + index + 16), m);
+			__m512d d3 = _mm512_sub_pd(_mm512_loadu_pd(data + index + 24), m);
+			a0 = _mm512_add_pd(a0, _mm512_mul_pd(d0, d0));
+			a1 = _mm512_add_pd(a1, _mm512_mul_pd(d1, d1));
+			a2 = _mm512_add_pd(a2, _mm512_mul_pd(d2, d2));
+			a3 = _mm512_add_pd(a3, _mm512_mul_pd(d3, d3));
+		}
+		double total = horizontalSum(_mm512_add_pd(_mm512_add_pd(a0, a1), _mm512_add_pd(a2, a3)));
+		return total + sumOfSquaredDeviationsScalar(data + index, numPoints - index, mean);
+	}
+
+	__attribute__((target("avx512f")))
+	static void shiftedSumsAvx512(const double* data, size_t numPoints, double shift, double& sum, double& sumSq)
+	{
+		__m512d k = _mm512_set1_pd(shift);
+		__m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd(), q0 = _mm512_setzero_pd(), q1 = _mm512_setzero_pd();
+		size_t index = 0;
+
+		for (; index + 16 <= numPoints; index += 16)
+		{
+			__m512d d0 = _mm512_sub_pd(_mm512_loadu_pd(data + index), k);
+			__m512d d1 = _mm512_sub_pd(_mm512_loadu_pd(data + index + 8), k);
+			s0 = _mm512_add_pd(s0, d0);
+			s1 = _mm512_add_pd(s1, d1);
+			q0 = _mm512_add_pd(q0, _mm512_mul_pd(d0, d0));
+			q1 = _mm512_add_pd(q1, _mm512_mul_pd(d1, d1));
+		}
+
+		double tailSum, tailSumSq;
+		shiftedSumsScalar(data + index, numPoints - index, shift, tailSum, tailSumSq);
+		sum = horizontalSum(_mm512_add_pd(s0, s1)) + tailSum;
+		sumSq = horizontalSum(_mm512_add_pd(q0, q1)) + tailSumSq;
+	}
+#endif
+
+	//
+	// Runtime dispatch.
+	//
+
+	typedef double (*SumKernel)(const double*, size_t);
+	typedef double (*SumOfSquaredDeviationsKernel)(const double*, size_t, double);
+	typedef void (*ShiftedSumsKernel)(const double*, size_t, double, double&, double&);
+
+	typedef struct Kernels
+	{
+		VectorStats::InstructionSet set;
+		SumKernel sum;
+		SumOfSquaredDeviationsKernel sumOfSquaredDeviations;
+		ShiftedSumsKernel shiftedSums;
+	} Kernels;
+
+	static VectorStats::InstructionSet bestSupportedInstructionSet()
+	{
+#ifdef PEAKS_X86_KERNELS
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f"))
+			return VectorStats::INSTRUCTION_SET_AVX512;
+		if (__builtin_cpu_supports("avx2"))
+			return VectorStats::INSTRUCTION_SET_AVX2;
+		if (__builtin_cpu_supports("sse2"))
+			return VectorStats::INSTRUCTION_SET_SSE2;
+#endif
+		return VectorStats::INSTRUCTION_SET_SCALAR;
+	}
+
+	// One entry per instruction set, in the order of VectorStats::InstructionSet.
+	static const Kernels KERNELS[] =
+	{
+		{ VectorStats::INSTRUCTION_SET_SCALAR, sumScalar, sumOfSquaredDeviationsScalar, shiftedSumsScalar },
+#ifdef PEAKS_X86_KERNELS
+		{ VectorStats::INSTRUCTION_SET_SSE2, sumSse2, sumOfSquaredDeviationsSse2, shiftedSumsSse2 },
+		{ VectorStats::INSTRUCTION_SET_AVX2, sumAvx2, sumOfSquaredDeviationsAvx2, shiftedSumsAvx2 },
+		{ VectorStats::INSTRUCTION_SET_AVX512, sumAvx512, sumOfSquaredDeviationsAvx512, shiftedSumsAvx512 },
+#endif
+	};
+
+	static const Kernels* kernelsFor(VectorStats::InstructionSet set)
+	{
+		size_t index = (size_t)set;
+		return (index < sizeof(KERNELS) / sizeof(KERNELS[0])) ? &KERNELS[index] : &KERNELS[0];
+	}
+
+	// The kernels are swapped as a whole by pointer, so a thread that is reading them while another calls
+	// setInstructionSet sees either the old set or the new one, never a mix.
+	static std::atomic<const Kernels*>& activeKernelsPointer()
+	{
+		static std::atomic<const Kernels*> kernels(kernelsFor(bestSupportedInstructionSet()));
+		return kernels;
+	}
+
+	static const Kernels& activeKernels()
+	{
+		return *activeKernelsPointer().load(std::memory_order_acquire);
+	}
+
+	VectorStats::InstructionSet VectorStats::instructionSet()
+	{
+		return activeKernels().set;
+	}
+
+	VectorStats::InstructionSet VectorStats::setInstructionSet(InstructionSet requested)
+	{
+		InstructionSet best = bestSupportedInstructionSet();
+		const Kernels* kernels = kernelsFor(requested < best ? requested : best);
+
+		activeKernelsPointer().store(kernels, std::memory_order_release);
+		return kernels->set;
+	}
+
+	const char* VectorStats::instructionSetName(InstructionSet set)
+	{
+		switch (set)
+		{
+		case INSTRUCTION_SET_SSE2:
+			return "sse2";
+		case INSTRUCTION_SET_AVX2:
+			return "avx2";
+		case INSTRUCTION_SET_AVX512:
+			return "avx512";
+		default:
+			break;
+		}
+		return "scalar";
+	}
+
+	double VectorStats::sum(const double* data, size_t numPoints)
+	{
+		return activeKernels().sum(data, numPoints);
+	}
+
+	double VectorStats::average(const double* data, size_t numPoints)
+	{
+		return sum(data, numPoints) / (double)numPoints;
+	}
+
+	double VectorStats::sumOfSquaredDeviations(const double* data, size_t numPoints, double mean)
+	{
+		return activeKernels().sumOfSquaredDeviations(data, numPoints, mean);
+	}
+
+	void VectorStats::meanAndVariance(const double* data, size_t numPoints, double& mean, double& variance)
+	{
+		const size_t BLOCK_SIZE = 2048;
+		ShiftedSumsKernel shiftedSums = activeKernels().shiftedSums;
+		double count = (double)0.0;
+		double m2 = (double)0.0;
+
+		mean = (double)0.0;
+
+		for (size_t start = 0; start < numPoints; start += BLOCK_SIZE)
+		{
+			size_t blockLen = (numPoints - start < BLOCK_SIZE) ? (numPoints - start) : BLOCK_SIZE;
+			double shift = data[start];
+			double blockSum, blockSumSq;
+
+			shiftedSums(data + start, blockLen, shift, blockSum, blockSumSq);
+
+			double blockCount = (double)blockLen;
+			double blockMean = shift + (blockSum / blockCount);
+			double blockM2 = blockSumSq - ((blockSum * blockSum) / blockCount);
+			if (blockM2 < (double)0.0)
+				blockM2 = (double)0.0;
+
+			// Merge the block into the running moments.
+			double newCount = count + blockCount;
+			double delta = blockMean - mean;
+			mean = mean + (delta * (blockCount / newCount));
+			m2 = m2 + blockM2 + ((delta * delta) * ((count * blockCount) / newCount));
+			count = newCount;
+		}
+
+		variance = (numPoints > 1) ? (m2 / (double)(numPoints - 1)) : (double)0.0;
+	}
+}
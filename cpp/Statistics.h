@@ -0,0 +1,141 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#ifndef _STATISTICS_
+#define _STATISTICS_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace Peaks
+{
+	/**
+	 * Mean and variance over everything pushed so far, accumulated in a single pass with Welford's method.
+	 */
+	class RunningStats
+	{
+	public:
+		RunningStats() { clear(); }
+
+		void push(double y)
+		{
+			++m_count;
+			double delta = y - m_mean;
+			m_mean = m_mean + (delta / (double)m_count);
+			m_m2 = m_m2 + (delta * (y - m_mean));
+		}
+
+		uint64_t count() const { return m_count; }
+		double mean() const { return m_mean; }
+		double variance() const;
+		double standardDeviation() const;
+
+		void clear()
+		{
+			m_count = 0;
+			m_mean = (double)0.0;
+			m_m2 = (double)0.0;
+		}
+
+	private:
+		uint64_t m_count;
+		double m_mean;
+		double m_m2; // Sum of squared differences from the mean
+	};
+
+	/**
+	 * Mean and variance over the most recent windowSize samples. Each push is O(1): the sample leaving the window
+	 * is swapped for the new one with Welford's update. The moments are recomputed from the window once per
+	 * windowSize samples so that rounding errors can't accumulate on long streams.
+	 */
+	class RollingStats
+	{
+	public:
+		RollingStats(size_t windowSize = 0);
+
+		void push(double y);
+
+		size_t windowSize() const { return m_window.size(); }
+		size_t count() const { return m_count; }
+		double mean() const { return m_mean; }
+		double variance() const;
+		double standardDeviation() const;
+
+		void clear();
+
+	private:
+		std::vector<double> m_window; // Ring buffer of the most recent samples
+		size_t m_next;                // Position in the ring buffer of the next sample
+		size_t m_count;               // Number of valid samples in the ring buffer
+		size_t m_sinceRecompute;
+		double m_mean;
+		double m_m2;
+
+		void recompute();
+	};
+
+	/**
+	 * Vectorized statistics kernels over contiguous arrays. On x86 the widest of SSE2, AVX2 and AVX-512 that the CPU
+	 * supports is selected at runtime; elsewhere a portable loop with independent accumulators is used.
+	 *
+	 * Every kernel splits the data over several independent accumulators, so the additions happen in a different order
+	 * than a plain sequential loop. The results agree with the sequential loop to within the usual summation bound of
+	 * numPoints * DBL_EPSILON * sum(|x|) (for the sum of squared deviations, x is (data[i] - mean)^2), and are
+	 * deterministic for a given instruction set.
+	 */
+	class VectorStats
+	{
+	public:
+		typedef enum InstructionSet
+		{
+			INSTRUCTION_SET_SCALAR = 0,
+			INSTRUCTION_SET_SSE2,
+			INSTRUCTION_SET_AVX2,
+			INSTRUCTION_SET_AVX512
+		} InstructionSet;
+
+		/**
+		 * The instruction set the kernels are using, and a way to force a narrower one (e.g., for comparisons).
+		 * Requests for an instruction set the CPU doesn't support are clamped to the best supported one. Changing it
+		 * is safe while other threads are computing stats; calls already under way finish with the set they started with.
+		 */
+		static InstructionSet instructionSet();
+		static InstructionSet setInstructionSet(InstructionSet requested);
+		static const char* instructionSetName(InstructionSet set);
+
+		static double sum(const double* data, size_t numPoints);
+		static double average(const double* data, size_t numPoints);
+		static double sumOfSquaredDeviations(const double* data, size_t numPoints, double mean);
+
+		/**
+		 * Fused mode: the mean and (sample) variance in a single pass over the data. The data is processed in blocks,
+		 * each block's moments are taken about its first sample to avoid cancellation, and the blocks are merged with
+		 * Chan's parallel update.
+		 */
+		static void meanAndVariance(const double* data, size_t numPoints, double& mean, double& variance);
+	};
+}
+
+#endif
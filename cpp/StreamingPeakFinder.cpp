@@ -0,0 +1,93 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "StreamingPeakFinder.h"
+
+namespace Peaks
+{
+	StreamingPeakFinder::StreamingPeakFinder(double threshold, PeakCallback callback) :
+		m_threshold(threshold),
+		m_callback(callback),
+		m_adaptive(false),
+		m_sigmas((double)0.0)
+	{
+		reset();
+	}
+
+	StreamingPeakFinder::StreamingPeakFinder(size_t windowSize, double sigmas, PeakCallback callback) :
+		m_threshold((double)0.0),
+		m_callback(callback),
+		m_adaptive(true),
+		m_sigmas(sigmas),
+		m_stats(windowSize)
+	{
+		reset();
+	}
+
+	void StreamingPeakFinder::reset()
+	{
+		m_scanner.clear();
+
+		if (m_adaptive)
+		{
+			m_stats.clear();
+			m_threshold = (double)0.0;
+		}
+	}
+
+	size_t StreamingPeakFinder::push(double y)
+	{
+		if (m_adaptive)
+		{
+			m_stats.push(y);
+			m_threshold = m_stats.mean() + (m_sigmas * m_stats.standardDeviation());
+		}
+
+		if (m_scanner.step(m_scanner.index, y, m_threshold) != ThresholdScanner::STEP_PEAK)
+			return 0;
+
+		if (m_callback)
+			m_callback(m_scanner.foundPeak);
+		return 1;
+	}
+
+	size_t StreamingPeakFinder::push(const double* data, size_t dataLen)
+	{
+		size_t numEmitted = 0;
+
+		// The threshold moves with every sample in adaptive mode, so those can't be scanned as a block.
+		if (m_adaptive)
+		{
+			for (size_t i = 0; i < dataLen; ++i)
+				numEmitted += push(data[i]);
+		}
+		else
+		{
+			m_scanner.scan(ArrayReader<double>(data), dataLen, m_threshold, [this, &numEmitted](const GraphPeak& peak, uint64_t) {
+				if (m_callback)
+					m_callback(peak);
+				++numEmitted;
+			});
+		}
+		return numEmitted;
+	}
+}
@@ -0,0 +1,85 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#ifndef _STREAMINGPEAKFINDER_
+#define _STREAMINGPEAKFINDER_
+
+#include <functional>
+
+#include "Peaks.h"
+#include "Statistics.h"
+
+namespace Peaks
+{
+	/**
+	 * Called with each peak as soon as its right trough is confirmed.
+	 */
+	typedef std::function<void(const GraphPeak&)> PeakCallback;
+
+	/**
+	 * Incremental version of Peaks::findPeaksOverThreshold for unbounded feeds. Samples can be pushed one at a time
+	 * or in chunks of any size; the detector state and the running area are carried across calls, so the peaks
+	 * reported are exactly the ones the batch function would find on the concatenated data. Memory use is constant.
+	 */
+	class StreamingPeakFinder
+	{
+	public:
+		StreamingPeakFinder(double threshold, PeakCallback callback);
+
+		/**
+		 * Adaptive mode: the threshold for each sample is the given number of standard deviations above the mean
+		 * of the most recent windowSize samples (including the current one), so slow drift in the signal doesn't
+		 * break detection.
+		 */
+		StreamingPeakFinder(size_t windowSize, double sigmas, PeakCallback callback);
+
+		/**
+		 * Processes the next sample(s). Returns the number of peaks emitted during the call.
+		 */
+		size_t push(double y);
+		size_t push(const double* data, size_t dataLen);
+
+		/**
+		 * Discards any partially detected peak (and, in adaptive mode, the window) and starts over at sample zero.
+		 */
+		void reset();
+
+		void setCallback(PeakCallback callback) { m_callback = callback; }
+
+		double threshold() const { return m_threshold; } // In adaptive mode, the threshold applied to the last sample
+		uint64_t numSamples() const { return m_scanner.index; }
+
+	private:
+		double m_threshold;
+		PeakCallback m_callback;
+
+		bool m_adaptive;
+		double m_sigmas;
+		RollingStats m_stats;
+
+		ThresholdScanner m_scanner;
+	};
+}
+
+#endif
@@ -0,0 +1,180 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "ThreadPool.h"
+
+namespace Peaks
+{
+	// The pool and worker the current thread belongs to, if it is one of the workers.
+	static thread_local ThreadPool* currentPool = NULL;
+	static thread_local size_t currentWorker = 0;
+
+	ThreadPool::ThreadPool(size_t numThreads) :
+		m_numQueued(0),
+		m_numPending(0),
+		m_numStolen(0),
+		m_stopping(false)
+	{
+		if (numThreads == 0)
+			numThreads = defaultNumThreads();
+
+		for (size_t i = 0; i < numThreads; ++i)
+			m_queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue));
+		for (size_t i = 0; i < numThreads; ++i)
+			m_workers.push_back(std::thread(&ThreadPool::run, this, i));
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_stopping = true;
+		}
+		m_taskAvailable.notify_all();
+
+		for (auto iter = m_workers.begin(); iter != m_workers.end(); ++iter)
+			(*iter).join();
+	}
+
+	size_t ThreadPool::defaultNumThreads()
+	{
+		size_t numThreads = std::thread::hardware_concurrency();
+		return (numThreads > 0) ? numThreads : 1;
+	}
+
+	uint64_t ThreadPool::numStolen() const
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		return m_numStolen;
+	}
+
+	void ThreadPool::submit(std::function<void()> task)
+	{
+		// Counted first, so the count never drops below the number of tasks that can be taken.
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			++m_numQueued;
+			++m_numPending;
+
+			if (currentPool != this)
+				m_tasks.push_back(task);
+		}
+
+		if (currentPool == this)
+		{
+			WorkerQueue& queue = *m_queues[currentWorker];
+			std::unique_lock<std::mutex> lock(queue.mutex);
+			queue.tasks.push_back(task);
+		}
+		m_taskAvailable.notify_one();
+	}
+
+	void ThreadPool::wait()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_idle.wait(lock, [this] { return m_numPending == 0; });
+	}
+
+	// Takes the newest task from the worker's own queue, then the oldest from the shared queue, then the oldest from
+	// another worker's queue.
+	bool ThreadPool::takeTask(size_t worker, std::function<void()>& task)
+	{
+		bool found = false;
+		bool stolen = false;
+
+		{
+			WorkerQueue& queue = *m_queues[worker];
+			std::unique_lock<std::mutex> lock(queue.mutex);
+
+			if (!queue.tasks.empty())
+			{
+				task = queue.tasks.back();
+				queue.tasks.pop_back();
+				found = true;
+			}
+		}
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		if (!found && !m_tasks.empty())
+		{
+			task = m_tasks.front();
+			m_tasks.pop_front();
+			found = true;
+		}
+		lock.unlock();
+
+		for (size_t i = 1; !found && (i < m_queues.size()); ++i)
+		{
+			WorkerQueue& queue = *m_queues[(worker + i) % m_queues.size()];
+			std::unique_lock<std::mutex> victimLock(queue.mutex);
+
+			if (!queue.tasks.empty())
+			{
+				task = queue.tasks.front();
+				queue.tasks.pop_front();
+				found = true;
+				stolen = true;
+			}
+		}
+
+		if (found)
+		{
+			lock.lock();
+			--m_numQueued;
+			if (stolen)
+				++m_numStolen;
+		}
+		return found;
+	}
+
+	// Worker thread body.
+	void ThreadPool::run(size_t worker)
+	{
+		currentPool = this;
+		currentWorker = worker;
+
+		while (true)
+		{
+			std::function<void()> task;
+
+			if (!takeTask(worker, task))
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_taskAvailable.wait(lock, [this] { return m_stopping || (m_numQueued > 0); });
+
+				if (m_numQueued == 0)
+					return;
+				continue;
+			}
+
+			task();
+
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				--m_numPending;
+				if (m_numPending == 0)
+					m_idle.notify_all();
+			}
+		}
+	}
+}
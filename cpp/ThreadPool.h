@@ -0,0 +1,88 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#ifndef _THREADPOOL_
+#define _THREADPOOL_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Peaks
+{
+	/**
+	 * Fixed set of worker threads. Tasks submitted from outside the pool run in order of submission. Tasks submitted by
+	 * a running task go on its worker's own queue instead, which the worker takes from newest first, so that related
+	 * work stays in its cache, and which idle workers steal from, oldest first.
+	 */
+	class ThreadPool
+	{
+	public:
+		/**
+		 * Zero threads means one per hardware thread.
+		 */
+		ThreadPool(size_t numThreads = 0);
+		~ThreadPool();
+
+		void submit(std::function<void()> task);
+
+		/**
+		 * Blocks until every task submitted so far, and every task those submit, has finished. Not to be called by a task.
+		 */
+		void wait();
+
+		size_t numThreads() const { return m_workers.size(); }
+		uint64_t numStolen() const; // Tasks taken from another worker's queue so far
+
+		static size_t defaultNumThreads();
+
+	private:
+		class WorkerQueue
+		{
+		public:
+			std::deque<std::function<void()>> tasks;
+			std::mutex mutex;
+		};
+
+		std::vector<std::thread> m_workers;
+		std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+		std::deque<std::function<void()>> m_tasks;
+		mutable std::mutex m_mutex;
+		std::condition_variable m_taskAvailable;
+		std::condition_variable m_idle;
+		size_t m_numQueued;  // Tasks waiting in any of the queues
+		size_t m_numPending; // Tasks queued or running
+		uint64_t m_numStolen;
+		bool m_stopping;
+
+		void run(size_t worker);
+		bool takeTask(size_t worker, std::function<void()>& task);
+	};
+}
+
+#endif
@@ -0,0 +1,648 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "VectorScan.h"
+#include "Statistics.h"
+
+#include <float.h>
+#include <math.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define PEAKS_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace Peaks
+{
+	static const size_t PROBE_LEN = 4;
+
+	//
+	// Portable kernels.
+	//
+
+	// Templates so that the float and int16_t kernels can share them. The threshold is of the sample type for floats
+	// and doubles, and an int for int16_t samples, since it may need to be one past the largest sample.
+	template <typename T, typename Limit>
+	static size_t findFirstAtOrAboveScalar(const T* data, size_t from, size_t to, Limit threshold)
+	{
+		size_t index = from;
+
+		while ((index < to) && (data[index] < threshold))
+			++index;
+		return index;
+	}
+
+	template <typename T, typename Limit>
+	static size_t findEndOfDescentScalar(const T* data, size_t from, size_t to, Limit threshold)
+	{
+		size_t index = from;
+
+		while ((index < to) && (data[index] < threshold) && (data[index] <= data[index - 1]))
+			++index;
+		return index;
+	}
+
+	static size_t selectAtOrAboveScalar(const double* data, size_t from, size_t to, double threshold, size_t* selection, size_t count)
+	{
+		// Always store, only advance on a match, so there's no branch to mispredict.
+		for (size_t index = from; index < to; ++index)
+		{
+			selection[count] = index;
+			count += (data[index] >= threshold) ? 1 : 0;
+		}
+		return count;
+	}
+
+#ifdef PEAKS_X86_KERNELS
+	// Stores the indices of the set bits of a comparison mask, without branching on each one.
+	static inline size_t appendMaskedIndices(unsigned mask, size_t base, size_t numLanes, size_t* selection, size_t count)
+	{
+		for (size_t lane = 0; lane < numLanes; ++lane)
+		{
+			selection[count] = base + lane;
+			count += (mask >> lane) & 1;
+		}
+		return count;
+	}
+
+	//
+	// SSE2 kernels: four registers of two lanes per iteration.
+	//
+
+	__attribute__((target("sse2")))
+	static size_t findFirstAtOrAboveSse2(const double* data, size_t from, size_t to, double threshold)
+	{
+		__m128d t = _mm_set1_pd(threshold);
+		size_t index = from;
+
+		for (; index + 8 <= to; index += 8)
+		{
+			int m0 = _mm_movemask_pd(_mm_cmpnlt_pd(_mm_loadu_pd(data + index), t));
+			int m1 = _mm_movemask_pd(_mm_cmpnlt_pd(_mm_loadu_pd(data + index + 2), t));
+			int m2 = _mm_movemask_pd(_mm_cmpnlt_pd(_mm_loadu_pd(data + index + 4), t));
+			int m3 = _mm_movemask_pd(_mm_cmpnlt_pd(_mm_loadu_pd(data + index + 6), t));
+			unsigned mask = (unsigned)(m0 | (m1 << 2) | (m2 << 4) | (m3 << 6));
+
+			if (mask)
+				return index + __builtin_ctz(mask);
+		}
+		return findFirstAtOrAboveScalar(data, index, to, threshold);
+	}
+
+	__attribute__((target("sse2")))
+	static size_t findEndOfDescentSse2(const double* data, size_t from, size_t to, double threshold)
+	{
+		__m128d t = _mm_set1_pd(threshold);
+		size_t index = from;
+
+		for (; index + 4 <= to; index += 4)
+		{
+			__m128d c0 = _mm_loadu_pd(data + index);
+			__m128d c1 = _mm_loadu_pd(data + index + 2);
+			__m128d p0 = _mm_loadu_pd(data + index - 1);
+			__m128d p1 = _mm_loadu_pd(data + index + 1);
+			int m0 = _mm_movemask_pd(_mm_or_pd(_mm_cmpnlt_pd(c0, t), _mm_cmpnle_pd(c0, p0)));
+			int m1 = _mm_movemask_pd(_mm_or_pd(_mm_cmpnlt_pd(c1, t), _mm_cmpnle_pd(c1, p1)));
+			unsigned mask = (unsigned)(m0 | (m1 << 2));
+
+			if (mask)
+				return index + __builtin_ctz(mask);
+		}
+		return findEndOfDescentScalar(data, index, to, threshold);
+	}
+
+	__attribute__((target("sse2")))
+	static size_t selectAtOrAboveSse2(const double* data, size_t dataLen, double threshold, size_t* selection)
+	{
+		__m128d t = _mm_set1_pd(threshold);
+		size_t index = 0;
+		size_t count = 0;
+
+		for (; index + 4 <= dataLen; index += 4)
+		{
+			int m0 = _mm_movemask_pd(_mm_cmpge_pd(_mm_loadu_pd(data + index), t));
+			int m1 = _mm_movemask_pd(_mm_cmpge_pd(_mm_loadu_pd(data + index + 2), t));
+			unsigned mask = (unsigned)(m0 | (m1 << 2));
+
+			if (mask)
+				count = appendMaskedIndices(mask, index, 4, selection, count);
+		}
+		return selectAtOrAboveScalar(data, index, dataLen, threshold, selection, count);
+	}
+
+	//
+	// AVX2 kernels: four registers of four lanes per iteration.
+	//
+
+	__attribute__((target("avx2")))
+	static size_t findFirstAtOrAboveAvx2(const double* data, size_t from, size_t to, double threshold)
+	{
+		__m256d t = _mm256_set1_pd(threshold);
+		size_t index = from;
+
+		for (; index + 16 <= to; index += 16)
+		{
+			int m0 = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(data + index), t, _CMP_NLT_UQ));
+			int m1 = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(data + index + 4), t, _CMP_NLT_UQ));
+			int m2 = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(data + index + 8), t, _CMP_NLT_UQ));
+			int m3 = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(data + index + 12), t, _CMP_NLT_UQ));
+			unsigned mask = (unsigned)(m0 | (m1 << 4) | (m2 << 8) | (m3 << 12));
+
+			if (mask)
+				return index + __builtin_ctz(mask);
+		}
+		return findFirstAtOrAboveSse2(data, index, to, threshold);
+	}
+
+	__attribute__((target("avx2")))
+	static size_t findEndOfDescentAvx2(const double* data, size_t from, size_t to, double threshold)
+	{
+		__m256d t = _mm256_set1_pd(threshold);
+		size_t index = from;
+
+		for (; index + 8 <= to; index += 8)
+		{
+			__m256d c0 = _mm256_loadu_pd(data + index);
+			__m256d c1 = _mm256_loadu_pd(data + index + 4);
+			__m256d p0 = _mm256_loadu_pd(data + index - 1);
+			__m256d p1 = _mm256_loadu_pd(data + index + 3);
+			int m0 = _mm256_movemask_pd(_mm256_or_pd(_mm256_cmp_pd(c0, t, _CMP_NLT_UQ), _mm256_cmp_pd(c0, p0, _CMP_NLE_UQ)));
+			int m1 = _mm256_movemask_pd(_mm256_or_pd(_mm256_cmp_pd(c1, t, _CMP_NLT_UQ), _mm256_cmp_pd(c1, p1, _CMP_NLE_UQ)));
+			unsigned mask = (unsigned)(m0 | (m1 << 4));
+
+			if (mask)
+				return index + __builtin_ctz(mask);
+		}
+		return findEndOfDescentSse2(data, index, to, threshold);
+	}
+
+	__attribute__((target("avx2")))
+	static size_t selectAtOrAboveAvx2(const double* data, size_t dataLen, double threshold, size_t* selection)
+	{
+		__m256d t = _mm256_set1_pd(threshold);
+		size_t index = 0;
+		size_t count = 0;
+
+		for (; index + 8 <= dataLen; index += 8)
+		{
+			int m0 = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(data + index), t, _CMP_GE_OQ));
+			int m1 = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(data + index + 4), t, _CMP_GE_OQ));
+			unsigned mask = (unsigned)(m0 | (m1 << 4));
+
+			if (mask)
+				count = appendMaskedIndices(mask, index, 8, selection, count);
+		}
+		return selectAtOrAboveScalar(data, index, dataLen, threshold, selection, count);
+	}
+
+	//
+	// AVX-512 kernels: four registers of eight lanes per iteration.
+	//
+
+	__attribute__((target("avx512f")))
+	static size_t findFirstAtOrAboveAvx512(const double* data, size_t from, size_t to, double threshold)
+	{
+		__m512d t = _mm512_set1_pd(threshold);
+		size_t index = from;
+
+		for (; index + 32 <= to; index += 32)
+		{
+			unsigned m0 = _mm512_cmp_pd_mask(_mm512_loadu_pd(data + index), t, _CMP_NLT_UQ);
+			unsigned m1 = _mm512_cmp_pd_mask(_mm512_loadu_pd(data + index + 8), t, _CMP_NLT_UQ);
+			unsigned m2 = _mm512_cmp_pd_mask(_mm512_loadu_pd(data + index + 16), t, _CMP_NLT_UQ);
+			unsigned m3 = _mm512_cmp_pd_mask(_mm512_loadu_pd(data + index + 24), t, _CMP_NLT_UQ);
+			unsigned mask = m0 | (m1 << 8) | (m2 << 16) | (m3 << 24);
+
+			if (mask)
+				return index + __builtin_ctz(mask);
+		}
+		return findFirstAtOrAboveAvx2(data, index, to, threshold);
+	}
+
+	__attribute__((target("avx512f")))
+	static size_t findEndOfDescentAvx512(const double* data, size_t from, size_t to, double threshold)
+	{
+		__m512d t = _mm512_set1_pd(threshold);
+		size_t index = from;
+
+		for (; index + 16 <= to; index += 16)
+		{
+			__m512d c0 = _mm512_loadu_pd(data + index);
+			__m512d c1 = _mm512_loadu_pd(data + index + 8);
+			__m512d p0 = _mm512_loadu_pd(data + index - 1);
+			__m512d p1 = _mm512_loadu_pd(data + index + 7);
+			unsigned m0 = _mm512_cmp_pd_mask(c0, t, _CMP_NLT_UQ) | _mm512_cmp_pd_mask(c0, p0, _CMP_NLE_UQ);
+			unsigned m1 = _mm512_cmp_pd_mask(c1, t, _CMP_NLT_UQ) | _mm512_cmp_pd_mask(c1, p1, _CMP_NLE_UQ);
+			unsigned mask = m0 | (m1 << 8);
+
+			if (mask)
+				return index + __builtin_ctz(mask);
+		}
+		return findEndOfDescentAvx2(data, index, to, threshold);
+	}
+
+	// The indices are compressed into place with a masked store rather than written one at a time.
+	__attribute__((target("avx512f")))
+	static size_t selectAtOrAboveAvx512(const double* data, size_t dataLen, double threshold, size_t* selection)
+	{
+		__m512d t = _mm512_set1_pd(threshold);
+		__m512i indices = _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+		__m512i step = _mm512_set1_epi64(8);
+		size_t index = 0;
+		size_t count = 0;
+
+		for (; index + 8 <= dataLen; index += 8)
+		{
+			__mmask8 mask = _mm512_cmp_pd_mask(_mm512_loadu_pd(data + index), t, _CMP_GE_OQ);
+
+			_mm512_mask_compressstoreu_epi64(selection + count, mask, indices);
+			count += __builtin_popcount(mask);
+			indices = _mm512_add_epi64(indices, step);
+		}
+		return selectAtOrAboveScalar(data, index, dataLen, threshold, selection, count);
+	}
+
+	//
+	// Float kernels: four registers of four lanes (SSE2) or eight lanes (AVX2) per iteration. The AVX2 kernels are used
+	// on AVX-512 machines too. The threshold has already been rounded to a float that compares the same way.
+	//
+
+	__attribute__((target("sse2")))
+	static size_t findFirstAtOrAboveSse2(const float* data, size_t from, size_t to, float threshold)
+	{
+		__m128 t = _mm_set1_ps(threshold);
+		size_t index = from;
+
+		for (; index + 16 <= to; index += 16)
+		{
+			int m0 = _mm_movemask_ps(_mm_cmpnlt_ps(_mm_loadu_ps(data + index), t));
+			int m1 = _mm_movemask_ps(_mm_cmpnlt_ps(_mm_loadu_ps(data + index + 4), t));
+			int m2 = _mm_movemask_ps(_mm_cmpnlt_ps(_mm_loadu_ps(data + index + 8), t));
+			int m3 = _mm_movemask_ps(_mm_cmpnlt_ps(_mm_loadu_ps(data + index + 12), t));
+			unsigned mask = (unsigned)(m0 | (m1 << 4) | (m2 << 8) | (m3 << 12));
+
+			if (mask)
+				return index + __builtin_ctz(mask);
+		}
+		return findFirstAtOrAboveScalar(data, index, to, threshold);
+	}
+
+	__attribute__((target("sse2")))
+	static size_t findEndOfDescentSse2(const float* data, size_t from, size_t to, float threshold)
+	{
+		__m128 t = _mm_set1_ps(threshold);
+		size_t index = from;
+
+		for (; index + 8 <= to; index += 8)
+		{
+			__m128 c0 = _mm_loadu_ps(data + index);
+			__m128 c1 = _mm_loadu_ps(data + index + 4);
+			__m128 p0 = _mm_loadu_ps(data + index - 1);
+			__m128 p1 = _mm_loadu_ps(data + index + 3);
+			int m0 = _mm_movemask_ps(_mm_or_ps(_mm_cmpnlt_ps(c0, t), _mm_cmpnle_ps(c0, p0)));
+			int m1 = _mm_movemask_ps(_mm_or_ps(_mm_cmpnlt_ps(c1, t), _mm_cmpnle_ps(c1, p1)));
+			unsigned mask = (unsigned)(m0 | (m1 << 4));
+
+			if (mask)
+				return index + __builtin_ctz(mask);
+		}
+		return findEndOfDescentScalar(data, index, to, threshold);
+	}
+
+	__attribute__((target("avx2")))
+	static size_t findFirstAtOrAboveAvx2(const float* data, size_t from, size_t to, float threshold)
+	{
+		__m256 t = _mm256_set1_ps(threshold);
+		size_t index = from;
+
+		for (; index + 32 <= to; index += 32)
+		{
+			int m0 = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(data + index), t, _CMP_NLT_UQ));
+			int m1 = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(data + index + 8), t, _CMP_NLT_UQ));
+			int m2 = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(data + index + 16), t, _CMP_NLT_UQ));
+			int m3 = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(data + index + 24), t, _CMP_NLT_UQ));
+			unsigned mask = (unsigned)m0 | ((unsigned)m1 << 8) | ((unsigned)m2 << 16) | ((unsigned)m3 << 24);
+
+			if (mask)
+				return index + __builtin_ctz(mask);
+		}
+		return findFirstAtOrAboveSse2(data, index, to, threshold);
+	}
+
+	__attribute__((target("avx2")))
+	static size_t findEndOfDescentAvx2(const float* data, size_t from, size_t to, float threshold)
+	{
+		__m256 t = _mm256_set1_ps(threshold);
+		size_t index = from;
+
+		for (; index + 16 <= to; index += 16)
+		{
+			__m256 c0 = _mm256_loadu_ps(data + index);
+			__m256 c1 = _mm256_loadu_ps(data + index + 8);
+			__m256 p0 = _mm256_loadu_ps(data + index - 1);
+			__m256 p1 = _mm256_loadu_ps(data + index + 7);
+			int m0 = _mm256_movemask_ps(_mm256_or_ps(_mm256_cmp_ps(c0, t, _CMP_NLT_UQ), _mm256_cmp_ps(c0, p0, _CMP_NLE_UQ)));
+			int m1 = _mm256_movemask_ps(_mm256_or_ps(_mm256_cmp_ps(c1, t, _CMP_NLT_UQ), _mm256_cmp_ps(c1, p1, _CMP_NLE_UQ)));
+			unsigned mask = (unsigned)(m0 | (m1 << 8));
+
+			if (mask)
+				return index + __builtin_ctz(mask);
+		}
+		return findEndOfDescentSse2(data, index, to, threshold);
+	}
+
+	//
+	// int16_t kernels: four registers of eight lanes (SSE2) or two of sixteen (AVX2) per iteration. There's no
+	// unsigned compare, so "not below the threshold" is "greater than the threshold minus one", and the byte movemask
+	// gives two bits per lane. The threshold is in [-32767, 32768], so one less than it is always an int16_t.
+	//
+
+	__attribute__((target("sse2")))
+	static size_t findFirstAtOrAboveSse2(const int16_t* data, size_t from, size_t to, int threshold)
+	{
+		__m128i t = _mm_set1_epi16((short)(threshold - 1));
+		size_t index = from;
+
+		for (; index + 32 <= to; index += 32)
+		{
+			uint64_t m0 = (uint64_t)_mm_movemask_epi8(_mm_cmpgt_epi16(_mm_loadu_si128((const __m128i*)(data + index)), t));
+			uint64_t m1 = (uint64_t)_mm_movemask_epi8(_mm_cmpgt_epi16(_mm_loadu_si128((const __m128i*)(data + index + 8)), t));
+			uint64_t m2 = (uint64_t)_mm_movemask_epi8(_mm_cmpgt_epi16(_mm_loadu_si128((const __m128i*)(data + index + 16)), t));
+			uint64_t m3 = (uint64_t)_mm_movemask_epi8(_mm_cmpgt_epi16(_mm_loadu_si128((const __m128i*)(data + index + 24)), t));
+			uint64_t mask = m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+
+			if (mask)
+				return index + (__builtin_ctzll(mask) >> 1);
+		}
+		return findFirstAtOrAboveScalar(data, index, to, threshold);
+	}
+
+	__attribute__((target("sse2")))
+	static size_t findEndOfDescentSse2(const int16_t* data, size_t from, size_t to, int threshold)
+	{
+		__m128i t = _mm_set1_epi16((short)(threshold - 1));
+		size_t index = from;
+
+		for (; index + 16 <= to; index += 16)
+		{
+			__m128i c0 = _mm_loadu_si128((const __m128i*)(data + index));
+			__m128i c1 = _mm_loadu_si128((const __m128i*)(data + index + 8));
+			__m128i p0 = _mm_loadu_si128((const __m128i*)(data + index - 1));
+			__m128i p1 = _mm_loadu_si128((const __m128i*)(data + index + 7));
+			unsigned m0 = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_cmpgt_epi16(c0, t), _mm_cmpgt_epi16(c0, p0)));
+			unsigned m1 = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_cmpgt_epi16(c1, t), _mm_cmpgt_epi16(c1, p1)));
+			unsigned mask = m0 | (m1 << 16);
+
+			if (mask)
+				return index + (__builtin_ctz(mask) >> 1);
+		}
+		return findEndOfDescentScalar(data, index, to, threshold);
+	}
+
+	__attribute__((target("avx2")))
+	static size_t findFirstAtOrAboveAvx2(const int16_t* data, size_t from, size_t to, int threshold)
+	{
+		__m256i t = _mm256_set1_epi16((short)(threshold - 1));
+		size_t index = from;
+
+		for (; index + 32 <= to; index += 32)
+		{
+			uint64_t m0 = (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi16(_mm256_loadu_si256((const __m256i*)(data + index)), t));
+			uint64_t m1 = (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi16(_mm256_loadu_si256((const __m256i*)(data + index + 16)), t));
+			uint64_t mask = m0 | (m1 << 32);
+
+			if (mask)
+				return index + (__builtin_ctzll(mask) >> 1);
+		}
+		return findFirstAtOrAboveSse2(data, index, to, threshold);
+	}
+
+	__attribute__((target("avx2")))
+	static size_t findEndOfDescentAvx2(const int16_t* data, size_t from, size_t to, int threshold)
+	{
+		__m256i t = _mm256_set1_epi16((short)(threshold - 1));
+		size_t index = from;
+
+		for (; index + 32 <= to; index += 32)
+		{
+			__m256i c0 = _mm256_loadu_si256((const __m256i*)(data + index));
+			__m256i c1 = _mm256_loadu_si256((const __m256i*)(data + index + 16));
+			__m256i p0 = _mm256_loadu_si256((const __m256i*)(data + index - 1));
+			__m256i p1 = _mm256_loadu_si256((const __m256i*)(data + index + 15));
+			uint64_t m0 = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpgt_epi16(c0, t), _mm256_cmpgt_epi16(c0, p0)));
+			uint64_t m1 = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpgt_epi16(c1, t), _mm256_cmpgt_epi16(c1, p1)));
+			uint64_t mask = m0 | (m1 << 32);
+
+			if (mask)
+				return index + (__builtin_ctzll(mask) >> 1);
+		}
+		return findEndOfDescentSse2(data, index, to, threshold);
+	}
+#endif
+
+	size_t VectorScan::findFirstAtOrAbove(const double* data, size_t from, size_t to, double threshold)
+	{
+		// Most runs in dense data end within a few samples, so try those before dispatching.
+		size_t probeEnd = (to - from > PROBE_LEN) ? (from + PROBE_LEN) : to;
+		from = findFirstAtOrAboveScalar(data, from, probeEnd, threshold);
+		if (from < probeEnd)
+			return from;
+
+#ifdef PEAKS_X86_KERNELS
+		switch (VectorStats::instructionSet())
+		{
+		case VectorStats::INSTRUCTION_SET_AVX512:
+			return findFirstAtOrAboveAvx512(data, from, to, threshold);
+		case VectorStats::INSTRUCTION_SET_AVX2:
+			return findFirstAtOrAboveAvx2(data, from, to, threshold);
+		case VectorStats::INSTRUCTION_SET_SSE2:
+			return findFirstAtOrAboveSse2(data, from, to, threshold);
+		default:
+			break;
+		}
+#endif
+		return findFirstAtOrAboveScalar(data, from, to, threshold);
+	}
+
+	size_t VectorScan::findEndOfDescent(const double* data, size_t from, size_t to, double threshold)
+	{
+		size_t probeEnd = (to - from > PROBE_LEN) ? (from + PROBE_LEN) : to;
+		from = findEndOfDescentScalar(data, from, probeEnd, threshold);
+		if (from < probeEnd)
+			return from;
+
+#ifdef PEAKS_X86_KERNELS
+		switch (VectorStats::instructionSet())
+		{
+		case VectorStats::INSTRUCTION_SET_AVX512:
+			return findEndOfDescentAvx512(data, from, to, threshold);
+		case VectorStats::INSTRUCTION_SET_AVX2:
+			return findEndOfDescentAvx2(data, from, to, threshold);
+		case VectorStats::INSTRUCTION_SET_SSE2:
+			return findEndOfDescentSse2(data, from, to, threshold);
+		default:
+			break;
+		}
+#endif
+		return findEndOfDescentScalar(data, from, to, threshold);
+	}
+
+	// The smallest float that isn't below the threshold. A float sample is below one exactly when it is below the other.
+	static float floatThreshold(double threshold)
+	{
+		if (threshold > (double)FLT_MAX)
+			return INFINITY;
+
+		float rounded = (float)threshold;
+		if ((double)rounded < threshold)
+			rounded = nextafterf(rounded, INFINITY);
+		return rounded;
+	}
+
+	size_t VectorScan::findFirstAtOrAbove(const float* data, size_t from, size_t to, double threshold)
+	{
+		float t = floatThreshold(threshold);
+		size_t probeEnd = (to - from > PROBE_LEN) ? (from + PROBE_LEN) : to;
+		from = findFirstAtOrAboveScalar(data, from, probeEnd, t);
+		if (from < probeEnd)
+			return from;
+
+#ifdef PEAKS_X86_KERNELS
+		switch (VectorStats::instructionSet())
+		{
+		case VectorStats::INSTRUCTION_SET_AVX512:
+		case VectorStats::INSTRUCTION_SET_AVX2:
+			return findFirstAtOrAboveAvx2(data, from, to, t);
+		case VectorStats::INSTRUCTION_SET_SSE2:
+			return findFirstAtOrAboveSse2(data, from, to, t);
+		default:
+			break;
+		}
+#endif
+		return findFirstAtOrAboveScalar(data, from, to, t);
+	}
+
+	size_t VectorScan::findEndOfDescent(const float* data, size_t from, size_t to, double threshold)
+	{
+		float t = floatThreshold(threshold);
+		size_t probeEnd = (to - from > PROBE_LEN) ? (from + PROBE_LEN) : to;
+		from = findEndOfDescentScalar(data, from, probeEnd, t);
+		if (from < probeEnd)
+			return from;
+
+#ifdef PEAKS_X86_KERNELS
+		switch (VectorStats::instructionSet())
+		{
+		case VectorStats::INSTRUCTION_SET_AVX512:
+		case VectorStats::INSTRUCTION_SET_AVX2:
+			return findEndOfDescentAvx2(data, from, to, t);
+		case VectorStats::INSTRUCTION_SET_SSE2:
+			return findEndOfDescentSse2(data, from, to, t);
+		default:
+			break;
+		}
+#endif
+		return findEndOfDescentScalar(data, from, to, t);
+	}
+
+	// An integer sample is below the threshold exactly when it is below the threshold's ceiling. Thresholds above every
+	// sample are clamped to one past the largest. Returns false if no sample can be below it, which includes a NaN.
+	static bool int16Threshold(double threshold, int* rounded)
+	{
+		double ceiling = ceil(threshold);
+
+		if (!(ceiling > (double)INT16_MIN))
+			return false;
+		*rounded = (ceiling > (double)INT16_MAX) ? (INT16_MAX + 1) : (int)ceiling;
+		return true;
+	}
+
+	size_t VectorScan::findFirstAtOrAbove(const int16_t* data, size_t from, size_t to, double threshold)
+	{
+		int t = 0;
+		if (!int16Threshold(threshold, &t))
+			return from;
+
+		size_t probeEnd = (to - from > PROBE_LEN) ? (from + PROBE_LEN) : to;
+		from = findFirstAtOrAboveScalar(data, from, probeEnd, t);
+		if (from < probeEnd)
+			return from;
+
+#ifdef PEAKS_X86_KERNELS
+		switch (VectorStats::instructionSet())
+		{
+		case VectorStats::INSTRUCTION_SET_AVX512:
+		case VectorStats::INSTRUCTION_SET_AVX2:
+			return findFirstAtOrAboveAvx2(data, from, to, t);
+		case VectorStats::INSTRUCTION_SET_SSE2:
+			return findFirstAtOrAboveSse2(data, from, to, t);
+		default:
+			break;
+		}
+#endif
+		return findFirstAtOrAboveScalar(data, from, to, t);
+	}
+
+	size_t VectorScan::findEndOfDescent(const int16_t* data, size_t from, size_t to, double threshold)
+	{
+		int t = 0;
+		if (!int16Threshold(threshold, &t))
+			return from;
+
+		size_t probeEnd = (to - from > PROBE_LEN) ? (from + PROBE_LEN) : to;
+		from = findEndOfDescentScalar(data, from, probeEnd, t);
+		if (from < probeEnd)
+			return from;
+
+#ifdef PEAKS_X86_KERNELS
+		switch (VectorStats::instructionSet())
+		{
+		case VectorStats::INSTRUCTION_SET_AVX512:
+		case VectorStats::INSTRUCTION_SET_AVX2:
+			return findEndOfDescentAvx2(data, from, to, t);
+		case VectorStats::INSTRUCTION_SET_SSE2:
+			return findEndOfDescentSse2(data, from, to, t);
+		default:
+			break;
+		}
+#endif
+		return findEndOfDescentScalar(data, from, to, t);
+	}
+
+	size_t VectorScan::selectAtOrAbove(const double* data, size_t dataLen, double threshold, size_t* selection)
+	{
+#ifdef PEAKS_X86_KERNELS
+		switch (VectorStats::instructionSet())
+		{
+		case VectorStats::INSTRUCTION_SET_AVX512:
+			return selectAtOrAboveAvx512(data, dataLen, threshold, selection);
+		case VectorStats::INSTRUCTION_SET_AVX2:
+			return selectAtOrAboveAvx2(data, dataLen, threshold, selection);
+		case VectorStats::INSTRUCTION_SET_SSE2:
+			return selectAtOrAboveSse2(data, dataLen, threshold, selection);
+		default:
+			break;
+		}
+#endif
+		return selectAtOrAboveScalar(data, 0, dataLen, threshold, selection, 0);
+	}
+}
@@ -0,0 +1,69 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#ifndef _VECTORSCAN_
+#define _VECTORSCAN_
+
+#include <stdint.h>
+#include <stdlib.h>
+
+namespace Peaks
+{
+	/**
+	 * Vectorized searches used by the peak finders to skip over runs of samples that can't change anything but the
+	 * position of a trough. They compare a block of samples at a time and use the movemask of the comparison to find
+	 * the first sample that ends the run. The instruction set follows VectorStats::instructionSet().
+	 *
+	 * The comparisons are the negations of the ones in the scalar state machine, so NaNs end a run just as they would
+	 * fall through the scalar comparisons. Float and int16_t samples are compared in their own type, with the threshold
+	 * rounded so that the results are the same as comparing them as doubles, which packs two or four times as many
+	 * samples into each vector.
+	 */
+	class VectorScan
+	{
+	public:
+		/**
+		 * Returns the index of the first sample in [from, to) that is not below the threshold, or to if there isn't one.
+		 */
+		static size_t findFirstAtOrAbove(const double* data, size_t from, size_t to, double threshold);
+		static size_t findFirstAtOrAbove(const float* data, size_t from, size_t to, double threshold);
+		static size_t findFirstAtOrAbove(const int16_t* data, size_t from, size_t to, double threshold);
+
+		/**
+		 * Returns the index of the first sample in [from, to) that is either not below the threshold or is greater than
+		 * the sample before it, or to if there isn't one. from must be at least one.
+		 */
+		static size_t findEndOfDescent(const double* data, size_t from, size_t to, double threshold);
+		static size_t findEndOfDescent(const float* data, size_t from, size_t to, double threshold);
+		static size_t findEndOfDescent(const int16_t* data, size_t from, size_t to, double threshold);
+
+		/**
+		 * Writes the index of every sample in [0, dataLen) that is at or above the threshold to selection, in order, and
+		 * returns how many there were. NaNs are never selected. selection must have room for dataLen indices.
+		 */
+		static size_t selectAtOrAbove(const double* data, size_t dataLen, double threshold, size_t* selection);
+	};
+}
+
+#endif
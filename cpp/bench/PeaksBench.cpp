@@ -0,0 +1,1050 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Benchmarks for the peak finders and the statistics helpers they use, on synthetic signals from 1K to 100M samples
+// and on the sample data set. Besides the usual Google Benchmark options, --baseline=<file> compares the results with
+// an earlier run saved with --benchmark_out=<file> --benchmark_out_format=json, and exits with an error if any
+// benchmark is slower by more than --tolerance=<fraction> (0.1 by default).
+
+#include <benchmark/benchmark.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "CsvLoader.h"
+#include "PeakHierarchy.h"
+#include "PeakIndex.h"
+#include "PeakTracker.h"
+#include "Peaks.h"
+#include "Statistics.h"
+
+#ifndef PEAKS_DATA_DIR
+#define PEAKS_DATA_DIR "../data"
+#endif
+
+namespace
+{
+	typedef enum Workload
+	{
+		WORKLOAD_SINE_NOISE = 0,  // Slow sine wave plus Gaussian noise
+		WORKLOAD_RANDOM_WALK,     // Sum of Gaussian steps, so peaks of every size
+		WORKLOAD_SPARSE_SPIKES,   // Low noise with an occasional short spike
+		WORKLOAD_DENSE_OSCILLATION, // A peak every four samples
+		NUM_WORKLOADS
+	} Workload;
+
+	const char* WORKLOAD_NAMES[NUM_WORKLOADS] = { "sine_noise", "random_walk", "sparse_spikes", "dense_oscillation" };
+
+	const size_t MIN_SAMPLES = 1000;
+	const size_t MAX_SAMPLES = 100000000;
+	const double SIGMAS = 1.0;
+	const size_t ROLLING_WINDOW = 1000;
+	const double PROMINENCE = 1.0;
+	const size_t PROMINENCE_DISTANCE = 5;
+	const double PROMINENCE_WIDTH = 2.0;
+	const size_t SWEEP_THRESHOLDS = 16;
+	const size_t TOP_K = 10;
+	const size_t TRACKER_FRAME = 1024;
+	const size_t TRACKER_HOP = 64;
+	const size_t MAX_TRACKER_FRAMES = 16384;
+	const size_t FILTER_WINDOW = 9;
+	const size_t FILTER_ORDER = 3;
+	const double FILTER_ALPHA = 0.2;
+	const char* PULLUPS_FILE_NAME = PEAKS_DATA_DIR "/pullups.csv";
+
+	// A generated signal and the threshold that the threshold benchmarks use on it.
+	class Dataset
+	{
+	public:
+		Workload workload;
+		size_t size;
+		double threshold;
+		std::vector<double> samples;
+
+		Dataset(Workload newWorkload, size_t newSize);
+	};
+
+	Dataset::Dataset(Workload newWorkload, size_t newSize) :
+		workload(newWorkload),
+		size(newSize),
+		threshold((double)0.0),
+		samples(newSize)
+	{
+		std::mt19937_64 generator(12345 + workload);
+		std::normal_distribution<double> noise((double)0.0, (double)1.0);
+
+		switch (workload)
+		{
+		case WORKLOAD_SINE_NOISE:
+			for (size_t i = 0; i < size; ++i)
+				samples[i] = sin((double)i * (2.0 * M_PI / 1000.0)) + (0.1 * noise(generator));
+			threshold = 0.5;
+			break;
+		case WORKLOAD_RANDOM_WALK:
+			{
+				double y = (double)0.0;
+
+				for (size_t i = 0; i < size; ++i)
+				{
+					y += noise(generator);
+					samples[i] = y;
+				}
+				threshold = Peaks::VectorStats::average(samples.data(), size);
+			}
+			break;
+		case WORKLOAD_SPARSE_SPIKES:
+			{
+				std::uniform_int_distribution<size_t> spacing(500, 1500);
+				const double SPIKE[] = { 1.0, 3.0, 5.0, 3.0, 1.0 };
+
+				for (size_t i = 0; i < size; ++i)
+					samples[i] = 0.05 * noise(generator);
+				for (size_t i = spacing(generator); i + 5 <= size; i += spacing(generator))
+				{
+					for (size_t j = 0; j < 5; ++j)
+						samples[i + j] += SPIKE[j];
+				}
+				threshold = 2.0;
+			}
+			break;
+		case WORKLOAD_DENSE_OSCILLATION:
+			for (size_t i = 0; i < size; ++i)
+				samples[i] = sin(((double)i + 0.5) * (M_PI / 2.0)) + (0.01 * noise(generator));
+			threshold = (double)0.0;
+			break;
+		default:
+			break;
+		}
+	}
+
+	// The benchmarks are registered so that each signal is used by all of them in turn, so only the most recent one
+	// is kept. At the largest size they're nearly a gigabyte each.
+	Dataset& dataset(Workload workload, size_t size)
+	{
+		static std::unique_ptr<Dataset> current;
+
+		if (!current || (current->workload != workload) || (current->size != size))
+		{
+			current.reset();
+			current.reset(new Dataset(workload, size));
+		}
+		return *current;
+	}
+
+	// The sample data set, with the first column (the timestamp) left out.
+	const Peaks::CsvLoader* pullups()
+	{
+		static std::unique_ptr<Peaks::CsvLoader> csv;
+		static bool attempted = false;
+
+		if (!attempted)
+		{
+			attempted = true;
+			csv.reset(new Peaks::CsvLoader(4));
+			if (!csv->load(PULLUPS_FILE_NAME))
+				csv.reset();
+		}
+		return csv.get();
+	}
+
+	// Reports the throughput, in samples (and peaks) per second.
+	void setRates(benchmark::State& state, size_t numSamples)
+	{
+		state.counters["samples"] = benchmark::Counter((double)numSamples * (double)state.iterations(), benchmark::Counter::kIsRate);
+	}
+
+	void setRates(benchmark::State& state, size_t numSamples, size_t numPeaks)
+	{
+		setRates(state, numSamples);
+		state.counters["peaks"] = benchmark::Counter((double)numPeaks * (double)state.iterations(), benchmark::Counter::kIsRate);
+	}
+
+	//
+	// Peak finders on arrays of doubles. Each returns the number of peaks it found.
+	//
+
+	typedef size_t (*ArrayFinder)(Dataset& data, Peaks::GraphPeakList& reused);
+
+	size_t thresholdVector(Dataset& data, Peaks::GraphPeakList&)
+	{
+		return Peaks::Peaks::findPeaksOverThreshold(data.samples, data.threshold).size();
+	}
+
+	size_t thresholdPointer(Dataset& data, Peaks::GraphPeakList&)
+	{
+		size_t numPeaks = 0;
+		Peaks::Peaks::findPeaksOverThreshold(data.samples.data(), data.size, &numPeaks, data.threshold);
+		return numPeaks;
+	}
+
+	size_t thresholdReusedList(Dataset& data, Peaks::GraphPeakList& reused)
+	{
+		return Peaks::Peaks::findPeaksOverThreshold(data.samples.data(), data.size, reused, data.threshold);
+	}
+
+	size_t thresholdParallel(Dataset& data, Peaks::GraphPeakList&)
+	{
+		return Peaks::Peaks::findPeaksOverThresholdParallel(data.samples, data.threshold).size();
+	}
+
+	size_t stdVector(Dataset& data, Peaks::GraphPeakList&)
+	{
+		return Peaks::Peaks::findPeaksOverStd(data.samples, SIGMAS).size();
+	}
+
+	size_t stdPointer(Dataset& data, Peaks::GraphPeakList&)
+	{
+		size_t numPeaks = 0;
+		Peaks::Peaks::findPeaksOverStd(data.samples.data(), data.size, &numPeaks, SIGMAS);
+		return numPeaks;
+	}
+
+	size_t stdReusedList(Dataset& data, Peaks::GraphPeakList& reused)
+	{
+		return Peaks::Peaks::findPeaksOverStd(data.samples.data(), data.size, reused, SIGMAS);
+	}
+
+	size_t stdSinglePass(Dataset& data, Peaks::GraphPeakList&)
+	{
+		return Peaks::Peaks::findPeaksOverStdSinglePass(data.samples, SIGMAS).size();
+	}
+
+	size_t rollingStd(Dataset& data, Peaks::GraphPeakList&)
+	{
+		return Peaks::Peaks::findPeaksOverRollingStd(data.samples, ROLLING_WINDOW, SIGMAS).size();
+	}
+
+	size_t prominence(Dataset& data, Peaks::GraphPeakList&)
+	{
+		Peaks::ProminenceOptions options;
+		options.minProminence = PROMINENCE;
+		options.minDistance = PROMINENCE_DISTANCE;
+		options.minWidth = PROMINENCE_WIDTH;
+		return Peaks::Peaks::findPeaksByProminence(data.samples, options).size();
+	}
+
+	void benchmarkArray(benchmark::State& state, Workload workload, ArrayFinder finder)
+	{
+		Dataset& data = dataset(workload, (size_t)state.range(0));
+		Peaks::GraphPeakList reused;
+		size_t numPeaks = 0;
+
+		for (auto _ : state)
+		{
+			numPeaks = finder(data, reused);
+			benchmark::ClobberMemory();
+		}
+		setRates(state, data.size, numPeaks);
+	}
+
+	// The caller-provided buffer version, with a buffer that is just big enough.
+	void benchmarkBuffer(benchmark::State& state, Workload workload, bool overStd)
+	{
+		Dataset& data = dataset(workload, (size_t)state.range(0));
+		Peaks::GraphPeakList reused;
+		size_t maxPeaks = overStd ? stdReusedList(data, reused) : thresholdReusedList(data, reused);
+
+		reused = Peaks::GraphPeakList();
+
+		std::vector<Peaks::GraphPeak> buffer(maxPeaks + 1);
+		size_t numPeaks = 0;
+
+		for (auto _ : state)
+		{
+			if (overStd)
+				Peaks::Peaks::findPeaksOverStd(data.samples.data(), data.size, buffer.data(), buffer.size(), &numPeaks, SIGMAS);
+			else
+				Peaks::Peaks::findPeaksOverThreshold(data.samples.data(), data.size, buffer.data(), buffer.size(), &numPeaks, data.threshold);
+			benchmark::ClobberMemory();
+		}
+		setRates(state, data.size, numPeaks);
+	}
+
+	// The GraphLine versions. The line is built before timing starts.
+	void benchmarkGraphLine(benchmark::State& state, Workload workload, bool overStd)
+	{
+		Dataset& data = dataset(workload, (size_t)state.range(0));
+		Peaks::GraphLine line;
+		size_t numPeaks = 0;
+
+		line.reserve(data.size);
+		for (size_t i = 0; i < data.size; ++i)
+			line.push_back(Peaks::GraphPoint(i, data.samples[i]));
+
+		for (auto _ : state)
+		{
+			if (overStd)
+				numPeaks = Peaks::Peaks::findPeaksOverStd(line, SIGMAS).size();
+			else
+				numPeaks = Peaks::Peaks::findPeaksOverThreshold(line, data.threshold).size();
+			benchmark::ClobberMemory();
+		}
+		setRates(state, data.size, numPeaks);
+	}
+
+	// The time-weighted GraphLine version, on timestamps 9 to 11 ms apart.
+	void benchmarkTimeWeighted(benchmark::State& state, Workload workload)
+	{
+		Dataset& data = dataset(workload, (size_t)state.range(0));
+		std::mt19937_64 generator(54321);
+		Peaks::GraphLine line;
+		uint64_t timestamp = 0;
+		size_t numPeaks = 0;
+
+		line.reserve(data.size);
+		for (size_t i = 0; i < data.size; ++i)
+		{
+			timestamp += 9 + (generator() % 3);
+			line.push_back(Peaks::GraphPoint(timestamp, data.samples[i]));
+		}
+
+		for (auto _ : state)
+		{
+			numPeaks = Peaks::Peaks::findPeaksOverThresholdTimeWeighted(line, data.threshold).size();
+			benchmark::ClobberMemory();
+		}
+		setRates(state, data.size, numPeaks);
+	}
+
+	// The SampleView versions, on a float copy of the signal made before timing starts.
+	void benchmarkFloatView(benchmark::State& state, Workload workload, bool overStd)
+	{
+		Dataset& data = dataset(workload, (size_t)state.range(0));
+		std::vector<float> samples(data.samples.begin(), data.samples.end());
+		Peaks::SampleView<float> view = Peaks::makeSampleView(samples.data(), samples.size());
+		size_t numPeaks = 0;
+
+		for (auto _ : state)
+		{
+			if (overStd)
+				numPeaks = Peaks::Peaks::findPeaksOverStd(view, SIGMAS).size();
+			else
+				numPeaks = Peaks::Peaks::findPeaksOverThreshold(view, data.threshold).size();
+			benchmark::ClobberMemory();
+		}
+		setRates(state, data.size, numPeaks);
+	}
+
+	// The same on int16_t ADC counts, scaled to use the full range, with the peaks either returned in a new list or
+	// written to a reused CompactGraphPeakList.
+	void benchmarkInt16View(benchmark::State& state, Workload workload, bool compact)
+	{
+		Dataset& data = dataset(workload, (size_t)state.range(0));
+		double largest = (double)0.0;
+
+		for (auto iter = data.samples.begin(); iter != data.samples.end(); ++iter)
+			largest = std::max(largest, fabs(*iter));
+
+		double scale = (largest > (double)0.0) ? ((double)INT16_MAX / largest) : (double)1.0;
+		std::vector<int16_t> samples(data.size);
+		for (size_t i = 0; i < data.size; ++i)
+			samples[i] = (int16_t)lround(data.samples[i] * scale);
+
+		Peaks::SampleView<int16_t> view = Peaks::makeSampleView(samples.data(), samples.size());
+		Peaks::CompactGraphPeakList peaks;
+		double threshold = data.threshold * scale;
+		size_t numPeaks = 0;
+
+		for (auto _ : state)
+		{
+			if (compact)
+				numPeaks = Peaks::Peaks::findPeaksOverThreshold(view, peaks, threshold);
+			else
+				numPeaks = Peaks::Peaks::findPeaksOverThreshold(view, threshold).size();
+			benchmark::ClobberMemory();
+		}
+		setRates(state, data.size, numPeaks);
+	}
+
+	Peaks::Prefilter benchmarkFilter(Peaks::FilterType type)
+	{
+		switch (type)
+		{
+		case Peaks::FILTER_MOVING_AVERAGE:
+			return Peaks::Prefilter::movingAverage(FILTER_WINDOW);
+		case Peaks::FILTER_EXPONENTIAL:
+			return Peaks::Prefilter::exponential(FILTER_ALPHA);
+		case Peaks::FILTER_SAVITZKY_GOLAY:
+			return Peaks::Prefilter::savitzkyGolay(FILTER_WINDOW, FILTER_ORDER);
+		case Peaks::FILTER_MEDIAN:
+			return Peaks::Prefilter::median(FILTER_WINDOW);
+		default:
+			return Peaks::Prefilter();
+		}
+	}
+
+	// Smoothing fused with the scan, or, for comparison, smoothing the whole array into a copy and then scanning that.
+	void benchmarkPrefilter(benchmark::State& state, Workload workload, Peaks::FilterType type, bool fused)
+	{
+		Dataset& data = dataset(workload, (size_t)state.range(0));
+		Peaks::Prefilter filter = benchmarkFilter(type);
+		size_t numPeaks = 0;
+
+		for (auto _ : state)
+		{
+			if (fused)
+			{
+				numPeaks = Peaks::Peaks::findPeaksOverThreshold(data.samples, filter, data.threshold).size();
+			}
+			else
+			{
+				std::vector<double> smoothed(data.size);
+
+				filter.reset();
+				filter.apply(Peaks::ArrayReader<double>(data.samples.data()), data.size, 0, data.size, smoothed.data());
+				numPeaks = Peaks::Peaks::findPeaksOverThreshold(smoothed, data.threshold).size();
+			}
+			benchmark::ClobberMemory();
+		}
+		setRates(state, data.size, numPeaks);
+	}
+
+	// Thresholds from one standard deviation below the mean to one above it, as in a sensitivity sweep.
+	std::vector<double> sweepThresholds(const Dataset& data)
+	{
+		double mean, variance;
+		std::vector<double> thresholds;
+
+		Peaks::VectorStats::meanAndVariance(data.samples.data(), data.size, mean, variance);
+		for (size_t i = 0; i < SWEEP_THRESHOLDS; ++i)
+			thresholds.push_back(mean + sqrt(variance) * ((2.0 * (double)i / (double)(SWEEP_THRESHOLDS - 1)) - 1.0));
+		return thresholds;
+	}
+
+	// A threshold sweep, either scanning the whole array for each threshold or querying a PeakIndex built beforehand.
+	void benchmarkSweep(benchmark::State& state, Workload workload, bool indexed)
+	{
+		Dataset& data = dataset(workload, (size_t)state.range(0));
+		std::vector<double> thresholds = sweepThresholds(data);
+		Peaks::PeakIndex index;
+		Peaks::GraphPeakList reused;
+		size_t numPeaks = 0;
+
+		if (indexed)
+			index.build(data.samples.data(), data.size);
+
+		for (auto _ : state)
+		{
+			numPeaks = 0;
+			for (auto iter = thresholds.begin(); iter != thresholds.end(); ++iter)
+			{
+				if (indexed)
+					numPeaks += index.findPeaksOverThreshold(*iter, reused);
+				else
+					numPeaks += Peaks::Peaks::findPeaksOverThreshold(data.samples.data(), data.size, reused, *iter);
+			}
+			benchmark::ClobberMemory();
+		}
+		setRates(state, data.size * thresholds.size(), numPeaks);
+	}
+
+	void benchmarkIndexBuild(benchmark::State& state, Workload workload)
+	{
+		Dataset& data = dataset(workload, (size_t)state.range(0));
+
+		for (auto _ : state)
+		{
+			Peaks::PeakIndex index(data.samples.data(), data.size);
+			benchmark::DoNotOptimize(index.mean());
+		}
+		setRates(state, data.size);
+	}
+
+	// The K largest peaks by area, from the full list of peaks sorted by GraphPeak::operator<.
+	void benchmarkSortedTopK(benchmark::State& state, Workload workload)
+	{
+		Dataset& data = dataset(workload, (size_t)state.range(0));
+		size_t numPeaks = 0;
+
+		for (auto _ : state)
+		{
+			Peaks::GraphPeakList peaks = Peaks::Peaks::findPeaksOverThreshold(data.samples, data.threshold);
+			std::sort(peaks.begin(), peaks.end(), std::greater<Peaks::GraphPeak>());
+			peaks.resize(std::min(peaks.size(), TOP_K));
+			numPeaks = peaks.size();
+			benchmark::ClobberMemory();
+		}
+		setRates(state, data.size, numPeaks);
+	}
+
+	void benchmarkHierarchyBuild(benchmark::State& state, Workload workload)
+	{
+		Dataset& data = dataset(workload, (size_t)state.range(0));
+		size_t numPeaks = 0;
+
+		for (auto _ : state)
+		{
+			Peaks::PeakHierarchy hierarchy(data.samples.data(), data.size);
+			numPeaks = hierarchy.size();
+			benchmark::DoNotOptimize(numPeaks);
+		}
+		setRates(state, data.size, numPeaks);
+	}
+
+	// The K most persistent peaks, from a PeakHierarchy built beforehand.
+	void benchmarkHierarchyTopK(benchmark::State& state, Workload workload)
+	{
+		Dataset& data = dataset(workload, (size_t)state.range(0));
+		Peaks::PeakHierarchy hierarchy(data.samples.data(), data.size);
+		size_t numPeaks = 0;
+
+		for (auto _ : state)
+		{
+			numPeaks = hierarchy.topByPersistence(TOP_K).size();
+			benchmark::ClobberMemory();
+		}
+		setRates(state, data.size, numPeaks);
+	}
+
+	// Tracking the peaks of overlapping windows that slide along the data, with each window's peaks found beforehand.
+	void benchmarkTracker(benchmark::State& state, Workload workload)
+	{
+		Dataset& data = dataset(workload, (size_t)state.range(0));
+		std::vector<Peaks::GraphPeakList> frames;
+		size_t numPeaks = 0;
+
+		size_t start = 0;
+
+		for (; (start + TRACKER_FRAME <= data.size) && (frames.size() < MAX_TRACKER_FRAMES); start += TRACKER_HOP)
+		{
+			Peaks::GraphPeakList peaks = Peaks::Peaks::findPeaksOverStd(std::vector<double>(data.samples.begin() + start, data.samples.begin() + start + TRACKER_FRAME), SIGMAS);
+
+			// Positions along the data rather than within the window, so that a peak stays put as the window moves.
+			for (auto iter = peaks.begin(); iter != peaks.end(); ++iter)
+			{
+				(*iter).leftTrough.x += start;
+				(*iter).peak.x += start;
+				(*iter).rightTrough.x += start;
+			}
+			numPeaks += peaks.size();
+			frames.push_back(peaks);
+		}
+
+		for (auto _ : state)
+		{
+			Peaks::PeakTracker tracker(TRACKER_HOP / 4, 1);
+
+			for (auto iter = frames.begin(); iter != frames.end(); ++iter)
+				tracker.update(*iter);
+			benchmark::DoNotOptimize(tracker.numTracksStarted());
+		}
+		setRates(state, start, numPeaks);
+		state.counters["frames"] = benchmark::Counter((double)frames.size() * (double)state.iterations(), benchmark::Counter::kIsRate);
+	}
+
+	//
+	// Statistics helpers, for each instruction set that the CPU supports.
+	//
+
+	typedef enum StatsKernel
+	{
+		STATS_SUM = 0,
+		STATS_AVERAGE,
+		STATS_SUM_OF_SQUARED_DEVIATIONS,
+		STATS_MEAN_AND_VARIANCE,
+		NUM_STATS_KERNELS
+	} StatsKernel;
+
+	const char* STATS_KERNEL_NAMES[NUM_STATS_KERNELS] = { "sum", "average", "sumOfSquaredDeviations", "meanAndVariance" };
+
+	void benchmarkVectorStats(benchmark::State& state, StatsKernel kernel, Peaks::VectorStats::InstructionSet instructionSet)
+	{
+		Dataset& data = dataset(WORKLOAD_SINE_NOISE, (size_t)state.range(0));
+		Peaks::VectorStats::InstructionSet previous = Peaks::VectorStats::instructionSet();
+
+		if (Peaks::VectorStats::setInstructionSet(instructionSet) != instructionSet)
+		{
+			Peaks::VectorStats::setInstructionSet(previous);
+			state.SkipWithError("The CPU doesn't support this instruction set");
+			return;
+		}
+
+		for (auto _ : state)
+		{
+			double mean = (double)0.0;
+			double variance = (double)0.0;
+
+			switch (kernel)
+			{
+			case STATS_SUM:
+				mean = Peaks::VectorStats::sum(data.samples.data(), data.size);
+				break;
+			case STATS_AVERAGE:
+				mean = Peaks::VectorStats::average(data.samples.data(), data.size);
+				break;
+			case STATS_SUM_OF_SQUARED_DEVIATIONS:
+				variance = Peaks::VectorStats::sumOfSquaredDeviations(data.samples.data(), data.size, (double)0.0);
+				break;
+			case STATS_MEAN_AND_VARIANCE:
+				Peaks::VectorStats::meanAndVariance(data.samples.data(), data.size, mean, variance);
+				break;
+			default:
+				break;
+			}
+			benchmark::DoNotOptimize(mean);
+			benchmark::DoNotOptimize(variance);
+		}
+		setRates(state, data.size);
+
+		Peaks::VectorStats::setInstructionSet(previous);
+	}
+
+	void benchmarkRunningStats(benchmark::State& state)
+	{
+		Dataset& data = dataset(WORKLOAD_SINE_NOISE, (size_t)state.range(0));
+
+		for (auto _ : state)
+		{
+			Peaks::RunningStats stats;
+
+			for (size_t i = 0; i < data.size; ++i)
+				stats.push(data.samples[i]);
+			benchmark::DoNotOptimize(stats.variance());
+		}
+		setRates(state, data.size);
+	}
+
+	void benchmarkRollingStats(benchmark::State& state)
+	{
+		Dataset& data = dataset(WORKLOAD_SINE_NOISE, (size_t)state.range(0));
+
+		for (auto _ : state)
+		{
+			Peaks::RollingStats stats(ROLLING_WINDOW);
+
+			for (size_t i = 0; i < data.size; ++i)
+				stats.push(data.samples[i]);
+			benchmark::DoNotOptimize(stats.variance());
+		}
+		setRates(state, data.size);
+	}
+
+	//
+	// The sample data set.
+	//
+
+	void benchmarkPullupsLoad(benchmark::State& state)
+	{
+		size_t numSamples = 0;
+
+		for (auto _ : state)
+		{
+			Peaks::CsvLoader csv(4);
+
+			if (!csv.load(PULLUPS_FILE_NAME))
+			{
+				state.SkipWithError("Couldn't read " PEAKS_DATA_DIR "/pullups.csv");
+				return;
+			}
+			numSamples = csv.numRows() * csv.numColumns();
+		}
+		setRates(state, numSamples);
+	}
+
+#ifdef PEAKS_HAVE_PMR
+	// A whole job: a fresh loader and fresh peak lists every time, from the heap or from an arena that is reset after each job.
+	void benchmarkPullupsJob(benchmark::State& state, bool useArena)
+	{
+		Peaks::MonotonicArena arena;
+		std::pmr::memory_resource* resource = useArena ? (std::pmr::memory_resource*)&arena : std::pmr::new_delete_resource();
+		size_t numSamples = 0;
+		size_t numPeaks = 0;
+
+		for (auto _ : state)
+		{
+			{
+				Peaks::CsvLoader csv(resource, 4, 0, 1);
+
+				if (!csv.load(PULLUPS_FILE_NAME))
+				{
+					state.SkipWithError("Couldn't read " PEAKS_DATA_DIR "/pullups.csv");
+					return;
+				}
+
+				numPeaks = 0;
+				for (size_t column = 1; column < csv.numColumns(); ++column)
+				{
+					Peaks::pmr::GraphPeakList peaks(resource);
+					numPeaks += Peaks::Peaks::findPeaksOverThreshold(csv.column(column), csv.numRows(), peaks, (double)0.0);
+				}
+				numSamples = csv.numRows() * csv.numColumns();
+			}
+			arena.reset();
+		}
+		setRates(state, numSamples, numPeaks);
+	}
+#endif
+
+	void benchmarkPullups(benchmark::State& state, bool overStd)
+	{
+		const Peaks::CsvLoader* csv = pullups();
+
+		if (!csv)
+		{
+			state.SkipWithError("Couldn't read " PEAKS_DATA_DIR "/pullups.csv");
+			return;
+		}
+
+		std::vector<std::vector<double>> axes;
+		size_t numPeaks = 0;
+
+		for (size_t column = 1; column < csv->numColumns(); ++column)
+			axes.push_back(std::vector<double>(csv->column(column), csv->column(column) + csv->numRows()));
+
+		for (auto _ : state)
+		{
+			numPeaks = 0;
+			for (auto iter = axes.begin(); iter != axes.end(); ++iter)
+			{
+				if (overStd)
+					numPeaks += Peaks::Peaks::findPeaksOverStd(*iter, SIGMAS).size();
+				else
+					numPeaks += Peaks::Peaks::findPeaksOverThreshold(*iter, (double)0.0).size();
+			}
+			benchmark::ClobberMemory();
+		}
+		setRates(state, axes.size() * csv->numRows(), numPeaks);
+	}
+
+	void benchmarkPullupsChannels(benchmark::State& state)
+	{
+		const Peaks::CsvLoader* csv = pullups();
+
+		if (!csv)
+		{
+			state.SkipWithError("Couldn't read " PEAKS_DATA_DIR "/pullups.csv");
+			return;
+		}
+
+		std::vector<const double*> channels;
+		size_t numPeaks = 0;
+
+		for (size_t column = 1; column < csv->numColumns(); ++column)
+			channels.push_back(csv->column(column));
+
+		std::vector<double> thresholds(channels.size(), (double)0.0);
+
+		for (auto _ : state)
+		{
+			std::vector<Peaks::GraphPeakList> channelPeaks = Peaks::Peaks::findPeaksOverThreshold(channels, csv->numRows(), thresholds);
+
+			numPeaks = 0;
+			for (auto iter = channelPeaks.begin(); iter != channelPeaks.end(); ++iter)
+				numPeaks += (*iter).size();
+			benchmark::ClobberMemory();
+		}
+		setRates(state, channels.size() * csv->numRows(), numPeaks);
+	}
+
+	// Registers everything. The loops are ordered so that each generated signal is used by every benchmark in turn.
+	void registerBenchmarks()
+	{
+		struct { const char* name; ArrayFinder finder; } arrayFinders[] = {
+			{ "findPeaksOverThreshold/vector", thresholdVector },
+			{ "findPeaksOverThreshold/pointer", thresholdPointer },
+			{ "findPeaksOverThreshold/reused_list", thresholdReusedList },
+			{ "findPeaksOverThresholdParallel/vector", thresholdParallel },
+			{ "findPeaksOverStd/vector", stdVector },
+			{ "findPeaksOverStd/pointer", stdPointer },
+			{ "findPeaksOverStd/reused_list", stdReusedList },
+			{ "findPeaksOverStdSinglePass/vector", stdSinglePass },
+			{ "findPeaksOverRollingStd/vector", rollingStd },
+			{ "findPeaksByProminence/vector", prominence },
+		};
+
+		for (size_t size = MIN_SAMPLES; size <= MAX_SAMPLES; size *= 10)
+		{
+			for (size_t kernel = 0; kernel < NUM_STATS_KERNELS; ++kernel)
+			{
+				for (int set = Peaks::VectorStats::INSTRUCTION_SET_SCALAR; set <= Peaks::VectorStats::INSTRUCTION_SET_AVX512; ++set)
+				{
+					Peaks::VectorStats::InstructionSet instructionSet = (Peaks::VectorStats::InstructionSet)set;
+					std::string name = std::string("VectorStats/") + STATS_KERNEL_NAMES[kernel] + "/" + Peaks::VectorStats::instructionSetName(instructionSet);
+
+					benchmark::RegisterBenchmark(name.c_str(), benchmarkVectorStats, (StatsKernel)kernel, instructionSet)->Arg(size)->UseRealTime();
+				}
+			}
+			benchmark::RegisterBenchmark("RunningStats/push", benchmarkRunningStats)->Arg(size)->UseRealTime();
+			benchmark::RegisterBenchmark("RollingStats/push", benchmarkRollingStats)->Arg(size)->UseRealTime();
+		}
+
+		for (size_t workload = 0; workload < NUM_WORKLOADS; ++workload)
+		{
+			for (size_t size = MIN_SAMPLES; size <= MAX_SAMPLES; size *= 10)
+			{
+				std::string suffix = std::string("/") + WORKLOAD_NAMES[workload];
+
+				for (size_t i = 0; i < sizeof(arrayFinders) / sizeof(arrayFinders[0]); ++i)
+				{
+					std::string name = arrayFinders[i].name + suffix;
+					benchmark::RegisterBenchmark(name.c_str(), benchmarkArray, (Workload)workload, arrayFinders[i].finder)->Arg(size)->UseRealTime();
+				}
+				for (int overStd = 0; overStd <= 1; ++overStd)
+				{
+					std::string function = overStd ? "findPeaksOverStd" : "findPeaksOverThreshold";
+
+					benchmark::RegisterBenchmark((function + "/buffer" + suffix).c_str(), benchmarkBuffer, (Workload)workload, (bool)overStd)->Arg(size)->UseRealTime();
+					benchmark::RegisterBenchmark((function + "/float_view" + suffix).c_str(), benchmarkFloatView, (Workload)workload, (bool)overStd)->Arg(size)->UseRealTime();
+					benchmark::RegisterBenchmark((function + "/graph_line" + suffix).c_str(), benchmarkGraphLine, (Workload)workload, (bool)overStd)->Arg(size)->UseRealTime();
+				}
+
+				benchmark::RegisterBenchmark(("findPeaksOverThreshold/time_weighted" + suffix).c_str(), benchmarkTimeWeighted, (Workload)workload)->Arg(size)->UseRealTime();
+				benchmark::RegisterBenchmark(("findPeaksOverThreshold/int16_view" + suffix).c_str(), benchmarkInt16View, (Workload)workload, false)->Arg(size)->UseRealTime();
+				benchmark::RegisterBenchmark(("findPeaksOverThreshold/int16_compact" + suffix).c_str(), benchmarkInt16View, (Workload)workload, true)->Arg(size)->UseRealTime();
+
+				const char* filterNames[] = { "none", "moving_average", "exponential", "savitzky_golay", "median" };
+				for (int type = Peaks::FILTER_MOVING_AVERAGE; type <= Peaks::FILTER_MEDIAN; ++type)
+				{
+					std::string name = std::string("findPeaksOverThreshold/prefilter_") + filterNames[type] + suffix;
+					benchmark::RegisterBenchmark(name.c_str(), benchmarkPrefilter, (Workload)workload, (Peaks::FilterType)type, true)->Arg(size)->UseRealTime();
+				}
+				benchmark::RegisterBenchmark(("findPeaksOverThreshold/prefilter_savitzky_golay_unfused" + suffix).c_str(), benchmarkPrefilter, (Workload)workload, Peaks::FILTER_SAVITZKY_GOLAY, false)->Arg(size)->UseRealTime();
+
+				benchmark::RegisterBenchmark(("findPeaksOverThreshold/sweep" + suffix).c_str(), benchmarkSweep, (Workload)workload, false)->Arg(size)->UseRealTime();
+				benchmark::RegisterBenchmark(("PeakIndex/build" + suffix).c_str(), benchmarkIndexBuild, (Workload)workload)->Arg(size)->UseRealTime();
+				benchmark::RegisterBenchmark(("PeakIndex/sweep" + suffix).c_str(), benchmarkSweep, (Workload)workload, true)->Arg(size)->UseRealTime();
+				benchmark::RegisterBenchmark(("findPeaksOverThreshold/sorted_top_k" + suffix).c_str(), benchmarkSortedTopK, (Workload)workload)->Arg(size)->UseRealTime();
+				benchmark::RegisterBenchmark(("PeakHierarchy/build" + suffix).c_str(), benchmarkHierarchyBuild, (Workload)workload)->Arg(size)->UseRealTime();
+				benchmark::RegisterBenchmark(("PeakHierarchy/top_k" + suffix).c_str(), benchmarkHierarchyTopK, (Workload)workload)->Arg(size)->UseRealTime();
+
+				// Smaller inputs don't hold a single frame.
+				if (size >= TRACKER_FRAME)
+					benchmark::RegisterBenchmark(("PeakTracker/update" + suffix).c_str(), benchmarkTracker, (Workload)workload)->Arg(size)->UseRealTime();
+			}
+		}
+
+		benchmark::RegisterBenchmark("pullups/CsvLoader/load", benchmarkPullupsLoad)->UseRealTime();
+		benchmark::RegisterBenchmark("pullups/findPeaksOverThreshold/vector", benchmarkPullups, false)->UseRealTime();
+		benchmark::RegisterBenchmark("pullups/findPeaksOverThreshold/channels", benchmarkPullupsChannels)->UseRealTime();
+		benchmark::RegisterBenchmark("pullups/findPeaksOverStd/vector", benchmarkPullups, true)->UseRealTime();
+#ifdef PEAKS_HAVE_PMR
+		benchmark::RegisterBenchmark("pullups/job/heap", benchmarkPullupsJob, false)->UseRealTime();
+		benchmark::RegisterBenchmark("pullups/job/arena", benchmarkPullupsJob, true)->UseRealTime();
+#endif
+	}
+
+	//
+	// Comparison with a baseline.
+	//
+
+	typedef std::map<std::string, double> Timings; // Benchmark name to nanoseconds per iteration
+
+	// Console output as usual, keeping the fastest time for each benchmark (there's more than one with repetitions).
+	class RecordingReporter : public benchmark::ConsoleReporter
+	{
+	public:
+		Timings timings;
+
+		RecordingReporter() : benchmark::ConsoleReporter(benchmark::ConsoleReporter::OO_Tabular) {}
+
+		void ReportRuns(const std::vector<Run>& runs)
+		{
+			for (auto iter = runs.begin(); iter != runs.end(); ++iter)
+			{
+				const Run& run = (*iter);
+				double time = run.GetAdjustedRealTime() * (1e9 / benchmark::GetTimeUnitMultiplier(run.time_unit));
+
+				// Runs that failed have no time.
+				if ((run.run_type == Run::RT_Iteration) && (time > (double)0.0))
+					keepFastest(timings, run.benchmark_name(), time);
+			}
+			benchmark::ConsoleReporter::ReportRuns(runs);
+		}
+
+		static void keepFastest(Timings& timings, const std::string& name, double time)
+		{
+			auto iter = timings.find(name);
+
+			if ((iter == timings.end()) || (time < iter->second))
+				timings[name] = time;
+		}
+	};
+
+	// Finds a key in one benchmark object of a JSON report and returns its value, without quotes if it's a string.
+	bool jsonValue(const std::string& object, const std::string& key, std::string& value)
+	{
+		size_t pos = object.find("\"" + key + "\"");
+		if (pos == std::string::npos)
+			return false;
+
+		pos = object.find(':', pos + key.length() + 2);
+		if (pos == std::string::npos)
+			return false;
+
+		pos = object.find_first_not_of(" \t\r\n", pos + 1);
+		if (pos == std::string::npos)
+			return false;
+
+		if (object[pos] == '"')
+		{
+			size_t end = pos + 1;
+
+			while ((end < object.length()) && (object[end] != '"'))
+				end += (object[end] == '\\') ? 2 : 1;
+			value = object.substr(pos + 1, end - pos - 1);
+		}
+		else
+		{
+			size_t end = object.find_first_of(",}\r\n", pos);
+			value = object.substr(pos, end - pos);
+		}
+		return true;
+	}
+
+	// Reads the per-iteration times from a report written with --benchmark_out_format=json.
+	bool readBaseline(const std::string& fileName, Timings& timings)
+	{
+		std::ifstream file(fileName);
+		std::stringstream contents;
+
+		if (!file)
+			return false;
+		contents << file.rdbuf();
+
+		std::string text = contents.str();
+		size_t pos = text.find("\"benchmarks\"");
+		if (pos == std::string::npos)
+			return false;
+
+		while ((pos = text.find('{', pos)) != std::string::npos)
+		{
+			// Find the end of the object, ignoring braces in strings.
+			size_t end = pos + 1;
+			bool inString = false;
+
+			for (; end < text.length(); ++end)
+			{
+				if (inString && (text[end] == '\\'))
+					++end;
+				else if (text[end] == '"')
+					inString = !inString;
+				else if (!inString && (text[end] == '}'))
+					break;
+			}
+
+			std::string object = text.substr(pos, end - pos + 1);
+			std::string name;
+			std::string runType;
+			std::string timeUnit;
+			std::string realTime;
+
+			if (jsonValue(object, "name", name) && jsonValue(object, "real_time", realTime) && jsonValue(object, "time_unit", timeUnit) &&
+				(!jsonValue(object, "run_type", runType) || (runType == "iteration")))
+			{
+				double time = atof(realTime.c_str());
+
+				if (timeUnit == "us")
+					time *= 1e3;
+				else if (timeUnit == "ms")
+					time *= 1e6;
+				else if (timeUnit == "s")
+					time *= 1e9;
+				RecordingReporter::keepFastest(timings, name, time);
+			}
+			pos = end;
+		}
+		return true;
+	}
+
+	// Prints the change in each benchmark that's in both sets of results. Returns the number that are slower than the
+	// baseline by more than the tolerance.
+	size_t compareWithBaseline(const Timings& baseline, const Timings& current, double tolerance)
+	{
+		size_t numRegressions = 0;
+
+		printf("\n%-70s %14s %14s %9s\n", "Comparison with the baseline", "Baseline (ns)", "Current (ns)", "Change");
+
+		for (auto iter = current.begin(); iter != current.end(); ++iter)
+		{
+			auto baselineIter = baseline.find(iter->first);
+
+			if (baselineIter == baseline.end())
+				continue;
+
+			double change = (iter->second - baselineIter->second) / baselineIter->second;
+			bool regressed = change > tolerance;
+
+			printf("%-70s %14.0f %14.0f %+8.1f%%%s\n", iter->first.c_str(), baselineIter->second, iter->second, change * 100.0, regressed ? "  REGRESSION" : "");
+			if (regressed)
+				++numRegressions;
+		}
+
+		printf("\n%zu regression(s) over %.0f%%\n", numRegressions, tolerance * 100.0);
+		return numRegressions;
+	}
+}
+
+// Entry point.
+int main(int argc, char** argv)
+{
+	const std::string OPTION_BASELINE = "--baseline=";
+	const std::string OPTION_TOLERANCE = "--tolerance=";
+
+	std::string baselineFileName = "";
+	double tolerance = 0.1;
+	std::vector<char*> args;
+
+	// Take out our own options, and leave the rest to Google Benchmark.
+	for (int i = 0; i < argc; ++i)
+	{
+		if (OPTION_BASELINE.compare(0, OPTION_BASELINE.length(), argv[i], 0, OPTION_BASELINE.length()) == 0)
+			baselineFileName = argv[i] + OPTION_BASELINE.length();
+		else if (OPTION_TOLERANCE.compare(0, OPTION_TOLERANCE.length(), argv[i], 0, OPTION_TOLERANCE.length()) == 0)
+			tolerance = atof(argv[i] + OPTION_TOLERANCE.length());
+		else
+			args.push_back(argv[i]);
+	}
+
+	Timings baseline;
+	if ((baselineFileName.length() > 0) && !readBaseline(baselineFileName, baseline))
+	{
+		fprintf(stderr, "Failed to read the baseline %s\n", baselineFileName.c_str());
+		return 1;
+	}
+
+	int numArgs = (int)args.size();
+	args.push_back(NULL);
+
+	registerBenchmarks();
+	benchmark::Initialize(&numArgs, args.data());
+	if (benchmark::ReportUnrecognizedArguments(numArgs, args.data()))
+		return 1;
+
+	RecordingReporter reporter;
+	benchmark::RunSpecifiedBenchmarks(&reporter);
+	benchmark::Shutdown();
+
+	if ((baselineFileName.length() > 0) && (compareWithBaseline(baseline, reporter.timings, tolerance) > 0))
+		return 1;
+	return 0;
+}
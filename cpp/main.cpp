@@ -19,65 +19,290 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <algorithm>
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <math.h>
+#include <string.h>
 #include <vector>
 
+#include "BlockReader.h"
+#include "CsvLoader.h"
 #include "Peaks.h"
+#include "JobServer.h"
+#include "PeakStats.h"
+#include "PeakWriter.h"
+#include "SampleFile.h"
+#include "StreamingPeakFinder.h"
 
-typedef std::vector<double> NumVec;
+// Default number of columns in the CSV file: timestamp, x, y, z.
+const size_t CSV_NUM_COLUMNS = 4;
 
-// Loads the peak data test file. Expected format is timestamp, x, y, z.
-std::vector<NumVec> readThreeAxisDataFromCsv(const std::string& fileName)
+// Size of the blocks read in --stream mode. Two of them are held in memory at a time.
+const size_t STREAM_BLOCK_SIZE = 1 << 20;
+
+// Units per second of the x values in --time-weighted mode, which are integers.
+const double TIMESTAMP_UNITS_PER_SECOND = 1000.0;
+
+// Converts timestamps in seconds to milliseconds. Logs such as pullups.csv only record whole seconds, so a timestamp
+// that repeats is spread evenly over the time until the next one (or, for the last, the gap before it) instead of
+// giving the samples that share it no width. Timestamps that go backwards (or aren't numbers) would give the peaks
+// negative widths, so they're clamped to the one before and reported on stderr.
+void setTimestamps(const double* data, size_t numRows, Peaks::GraphLine& line)
 {
-	std::vector<NumVec> columns;
-	std::vector<double> tsList, xList, yList, zList;
-
-	std::string line;
-	std::ifstream infile(fileName);
-
-	while (std::getline(infile, line, '\n'))
-	{
-		std::istringstream iss(line);
-		std::string value;
-		uint64_t ts = 0;
-		double x = 0.0, y = 0.0, z = 0.0;
-
-		iss >> ts;
-		iss.ignore(256, ',');
-		iss >> x;
-		iss.ignore(256, ',');
-		iss >> y;
-		iss.ignore(256, ',');
-		iss >> z;
-
-		tsList.push_back(ts);
-		xList.push_back(x);
-		yList.push_back(y);
-		zList.push_back(z);
-	}
-
-	columns.push_back(tsList);
-	columns.push_back(xList);
-	columns.push_back(yList);
-	columns.push_back(zList);
-	return columns;
+	std::vector<double> timestamps(data, data + numRows);
+	size_t numClamped = 0;
+
+	for (size_t row = 0; row < numRows; ++row)
+	{
+		bool valid = isfinite(timestamps[row]) && ((row == 0) || (timestamps[row] >= timestamps[row - 1]));
+
+		if (!valid)
+		{
+			timestamps[row] = (row > 0) ? timestamps[row - 1] : 0.0;
+			++numClamped;
+		}
+	}
+	if (numClamped > 0)
+		std::cerr << "Warning: " << numClamped << " timestamp(s) went backwards or weren't numbers, and were clamped to the one before." << std::endl;
+
+	double gap = 1.0; // Seconds, until there are two timestamps to take it from
+	size_t start = 0;
+
+	while (start < numRows)
+	{
+		size_t end = start + 1;
+
+		while ((end < numRows) && (timestamps[end] == timestamps[start]))
+			++end;
+		if ((end < numRows) && (timestamps[end] > timestamps[start]))
+			gap = timestamps[end] - timestamps[start];
+
+		for (size_t row = start; row < end; ++row)
+		{
+			double seconds = timestamps[start] + ((gap * (double)(row - start)) / (double)(end - start));
+			line[row].x = (uint64_t)llround(seconds * TIMESTAMP_UNITS_PER_SECOND);
+		}
+		start = end;
+	}
 }
 
-std::vector<Peaks::GraphPeakList> findPeaks(const std::vector<NumVec>& csvData, double threshold)
+// Finds the peaks in each column of the CSV file other than the first, with the area over the timestamps in the first.
+std::vector<Peaks::GraphPeakList> findPeaksTimeWeighted(const Peaks::CsvLoader& csv, double threshold)
 {
-	std::vector<Peaks::GraphPeakList> axisPeaks;
+	std::vector<Peaks::GraphPeakList> channelPeaks;
+	Peaks::GraphLine line(csv.numRows());
 
-	auto csvIter = csvData.begin();
-	++csvIter; // Skip over the timestamp column
+	setTimestamps(csv.column(0), csv.numRows(), line);
 
-	for (; csvIter != csvData.end(); ++csvIter)
+	for (size_t column = 1; column < csv.numColumns(); ++column)
 	{
-		auto peaks = Peaks::Peaks::findPeaksOverThreshold((*csvIter), threshold);
-		axisPeaks.push_back(peaks);
+		for (size_t row = 0; row < csv.numRows(); ++row)
+			line[row].y = csv.column(column)[row];
+		channelPeaks.push_back(Peaks::Peaks::findPeaksOverThresholdTimeWeighted(line, threshold));
 	}
-	return axisPeaks;
+	return channelPeaks;
+}
+
+// Finds the peaks in each column of the CSV file other than the first, which is the timestamp.
+std::vector<Peaks::GraphPeakList> findPeaks(const Peaks::CsvLoader& csv, double threshold, const Peaks::Prefilter& filter)
+{
+	std::vector<const double*> channels;
+
+	for (size_t column = 1; column < csv.numColumns(); ++column)
+		channels.push_back(csv.column(column));
+
+	// The filtered version takes one channel at a time.
+	if (filter.type() != Peaks::FILTER_NONE)
+	{
+		std::vector<Peaks::GraphPeakList> channelPeaks;
+
+		for (auto iter = channels.begin(); iter != channels.end(); ++iter)
+			channelPeaks.push_back(Peaks::Peaks::findPeaksOverThreshold(*iter, csv.numRows(), filter, threshold));
+		return channelPeaks;
+	}
+
+	std::vector<double> thresholds(channels.size(), threshold);
+	return Peaks::Peaks::findPeaksOverThreshold(channels, csv.numRows(), thresholds);
+}
+
+// Finds the peaks in each channel of a binary file, reading the samples where they are in the mapped file.
+template <typename T>
+std::vector<Peaks::GraphPeakList> findPeaks(const Peaks::SampleFile& file, double threshold, const Peaks::Prefilter& filter)
+{
+	std::vector<Peaks::GraphPeakList> channelPeaks;
+
+	for (size_t channel = 0; channel < file.numChannels(); ++channel)
+	{
+		if (filter.type() != Peaks::FILTER_NONE)
+			channelPeaks.push_back(Peaks::Peaks::findPeaksOverThreshold(file.channel<T>(channel), filter, threshold));
+		else
+			channelPeaks.push_back(Peaks::Peaks::findPeaksOverThreshold(file.channel<T>(channel), threshold));
+	}
+	return channelPeaks;
+}
+
+std::vector<Peaks::GraphPeakList> findPeaks(const Peaks::SampleFile& file, double threshold, const Peaks::Prefilter& filter)
+{
+	if (file.dataType() == Peaks::SampleFile::DATA_TYPE_FLOAT32)
+		return findPeaks<float>(file, threshold, filter);
+	return findPeaks<double>(file, threshold, filter);
+}
+
+// Writes the peaks found in each channel, grouped by channel.
+void writePeaks(Peaks::PeakWriter& writer, const std::vector<Peaks::GraphPeakList>& axisPeaks)
+{
+	for (size_t channel = 0; channel < axisPeaks.size(); ++channel)
+	{
+		const Peaks::GraphPeakList& peaks = axisPeaks[channel];
+
+		writer.beginChannel();
+
+		for (auto peakIter = peaks.begin(); peakIter != peaks.end(); ++peakIter)
+			writer.write(channel, (*peakIter));
+
+		writer.endChannel();
+	}
+}
+
+// Prints the counters collected with --profile.
+void printProfile(const Peaks::PeakStats& stats, uint64_t loadNanoseconds)
+{
+	std::cerr << "Profile" << std::endl;
+	std::cerr << "Calls: " << stats.numCalls << std::endl;
+	std::cerr << "Samples scanned: " << stats.samplesScanned << std::endl;
+	std::cerr << "State transitions: " << stats.stateTransitions << std::endl;
+	std::cerr << "Peaks emitted: " << stats.peaksEmitted << std::endl;
+	std::cerr << "Bytes allocated: " << stats.bytesAllocated << std::endl;
+	std::cerr << "Load time (ns): " << loadNanoseconds << std::endl;
+	for (size_t phase = 0; phase < Peaks::PeakStats::NUM_PHASES; ++phase)
+		std::cerr << "Phase " << Peaks::PeakStats::phaseName((Peaks::PeakStats::Phase)phase) << " time (ns): " << stats.phaseNanoseconds[phase] << std::endl;
+	std::cerr << "Allocation time (ns): " << stats.allocationNanoseconds << std::endl;
+	std::cerr << "Total time (ns): " << stats.totalNanoseconds << std::endl;
+}
+
+// Creates a streaming finder for each channel that writes each peak as soon as it is confirmed.
+std::vector<Peaks::StreamingPeakFinder> makeStreamingFinders(size_t numChannels, double threshold, Peaks::PeakWriter& writer)
+{
+	std::vector<Peaks::StreamingPeakFinder> finders;
+
+	for (size_t channel = 0; channel < numChannels; ++channel)
+	{
+		finders.push_back(Peaks::StreamingPeakFinder(threshold, [channel, &writer](const Peaks::GraphPeak& peak) {
+			writer.write(channel, peak);
+		}));
+	}
+	return finders;
+}
+
+// Finds the peaks in each column of the CSV file other than the first, a block at a time, so that memory use doesn't
+// depend on the size of the file. Lines that straddle two blocks are put back together before they're parsed.
+bool streamPeaks(const std::string& fileName, size_t numColumns, size_t numHeaderRows, double threshold, Peaks::PeakWriter& writer)
+{
+	Peaks::BlockReader reader(STREAM_BLOCK_SIZE);
+
+	if (!reader.open(fileName))
+		return false;
+
+	std::vector<Peaks::StreamingPeakFinder> finders = makeStreamingFinders((numColumns > 1) ? (numColumns - 1) : 0, threshold, writer);
+	std::vector<double> values(numColumns);
+	std::string partialLine;
+
+	auto processLine = [&](const char* start, const char* end) {
+		if (numHeaderRows > 0)
+			--numHeaderRows;
+		else if (Peaks::CsvLoader::parseLine(start, end, numColumns, values.data()))
+		{
+			for (size_t column = 1; column < numColumns; ++column)
+				finders[column - 1].push(values[column]);
+		}
+	};
+
+	const char* block;
+	size_t blockLen;
+	while (reader.next(block, blockLen))
+	{
+		const char* pos = block;
+		const char* end = block + blockLen;
+
+		while (pos < end)
+		{
+			const char* newline = (const char*)memchr(pos, '\n', end - pos);
+
+			if (!newline)
+			{
+				partialLine.append(pos, end - pos);
+				break;
+			}
+			if (partialLine.empty())
+			{
+				processLine(pos, newline + 1);
+			}
+			else
+			{
+				partialLine.append(pos, newline + 1 - pos);
+				processLine(partialLine.data(), partialLine.data() + partialLine.size());
+				partialLine.clear();
+			}
+			pos = newline + 1;
+		}
+		writer.flush();
+	}
+	if (!partialLine.empty())
+		processLine(partialLine.data(), partialLine.data() + partialLine.size());
+	writer.flush();
+
+	return !reader.failed();
+}
+
+// Pushes a block of numFrames frames, or of the samples of one channel if there's only one finder, to the finders.
+template <typename T>
+void pushSamples(const char* block, size_t numFrames, std::vector<Peaks::StreamingPeakFinder>& finders, size_t firstFinder, size_t numFinders)
+{
+	for (size_t frame = 0; frame < numFrames; ++frame)
+	{
+		for (size_t channel = 0; channel < numFinders; ++channel, block += sizeof(T))
+		{
+			T sample;
+
+			memcpy(&sample, block, sizeof(T)); // The block needn't be aligned
+			finders[firstFinder + channel].push((double)sample);
+		}
+	}
+}
+
+// Finds the peaks in each channel of a binary file a block at a time. Interleaved channels are read together; planar
+// channels are read one after the other.
+bool streamPeaks(const std::string& fileName, const Peaks::SampleFile& file, double threshold, Peaks::PeakWriter& writer)
+{
+	size_t sampleSize = Peaks::SampleFile::sampleSize(file.dataType());
+	bool interleaved = (file.layout() == Peaks::SampleFile::LAYOUT_INTERLEAVED);
+	size_t numPasses = interleaved ? 1 : file.numChannels();
+	size_t numFinders = interleaved ? file.numChannels() : 1;
+	size_t frameSize = sampleSize * numFinders;
+	Peaks::BlockReader reader(std::max((size_t)1, STREAM_BLOCK_SIZE / frameSize) * frameSize);
+	std::vector<Peaks::StreamingPeakFinder> finders = makeStreamingFinders(file.numChannels(), threshold, writer);
+
+	for (size_t pass = 0; pass < numPasses; ++pass)
+	{
+		uint64_t passLen = (uint64_t)file.numSamples() * frameSize;
+
+		if (!reader.open(fileName, file.dataOffset() + (pass * passLen), passLen))
+			return false;
+
+		const char* block;
+		size_t blockLen;
+		while (reader.next(block, blockLen))
+		{
+			if (file.dataType() == Peaks::SampleFile::DATA_TYPE_FLOAT32)
+				pushSamples<float>(block, blockLen / frameSize, finders, pass, numFinders);
+			else
+				pushSamples<double>(block, blockLen / frameSize, finders, pass, numFinders);
+			writer.flush();
+		}
+		if (reader.failed())
+			return false;
+	}
+	return true;
 }
 
 // Entry point.
@@ -85,12 +310,40 @@ int main(int argc, const char * argv[])
 {
 	const std::string OPTION_CSV_FILE = "--csv";
 	const std::string OPTION_THRESHOLD = "--threshold";
+	const std::string OPTION_COLUMNS = "--columns";
+	const std::string OPTION_HEADER_ROWS = "--header-rows";
+	const std::string OPTION_BINARY_FILE = "--binary";
+	const std::string OPTION_NPY_FILE = "--npy";
+	const std::string OPTION_DATA_TYPE = "--dtype";
+	const std::string OPTION_CHANNELS = "--channels";
+	const std::string OPTION_LAYOUT = "--layout";
+	const std::string OPTION_STREAM = "--stream";
+	const std::string OPTION_OUTPUT = "--output";
+	const std::string OPTION_PROFILE = "--profile";
+	const std::string OPTION_FILTER = "--filter";
+	const std::string OPTION_TIME_WEIGHTED = "--time-weighted";
+	const std::string OPTION_SERVE = "--serve";
+	const std::string OPTION_SOCKET = "--socket";
 
 	std::string csvFileName = "";
 	double threshold = (double)0.0;
+	size_t numColumns = CSV_NUM_COLUMNS;
+	size_t numHeaderRows = 0;
+	std::string binaryFileName = "";
+	std::string npyFileName = "";
+	Peaks::SampleFile::DataType dataType = Peaks::SampleFile::DATA_TYPE_FLOAT64;
+	Peaks::SampleFile::Layout layout = Peaks::SampleFile::LAYOUT_INTERLEAVED;
+	size_t numChannels = 1;
+	bool stream = false;
+	bool profile = false;
+	bool timeWeighted = false;
+	bool serve = false;
+	std::string socketPath = "";
+	Peaks::PeakWriter::Format outputFormat = Peaks::PeakWriter::FORMAT_TEXT;
+	Peaks::Prefilter filter;
 
 	// Parse the command line options.
-	for (size_t i = 1; i < argc; ++i)
+	for (int i = 1; i < argc; ++i)
 	{
 		if ((OPTION_CSV_FILE.compare(argv[i]) == 0) && (i + 1 < argc))
 		{
@@ -100,27 +353,188 @@ int main(int argc, const char * argv[])
 		{
 			threshold = atof(argv[++i]);
 		}
+		if ((OPTION_COLUMNS.compare(argv[i]) == 0) && (i + 1 < argc))
+		{
+			numColumns = (size_t)atol(argv[++i]);
+		}
+		if ((OPTION_HEADER_ROWS.compare(argv[i]) == 0) && (i + 1 < argc))
+		{
+			numHeaderRows = (size_t)atol(argv[++i]);
+		}
+		if ((OPTION_BINARY_FILE.compare(argv[i]) == 0) && (i + 1 < argc))
+		{
+			binaryFileName = argv[++i];
+		}
+		if ((OPTION_NPY_FILE.compare(argv[i]) == 0) && (i + 1 < argc))
+		{
+			npyFileName = argv[++i];
+		}
+		if ((OPTION_DATA_TYPE.compare(argv[i]) == 0) && (i + 1 < argc))
+		{
+			if (!Peaks::SampleFile::parseDataType(argv[++i], dataType))
+			{
+				std::cerr << "The data type must be f64 or f32" << std::endl;
+				return 1;
+			}
+		}
+		if (OPTION_STREAM.compare(argv[i]) == 0)
+		{
+			stream = true;
+		}
+		if (OPTION_PROFILE.compare(argv[i]) == 0)
+		{
+			profile = true;
+		}
+		if (OPTION_TIME_WEIGHTED.compare(argv[i]) == 0)
+		{
+			timeWeighted = true;
+		}
+		if (OPTION_SERVE.compare(argv[i]) == 0)
+		{
+			serve = true;
+		}
+		if ((OPTION_SOCKET.compare(argv[i]) == 0) && (i + 1 < argc))
+		{
+			socketPath = argv[++i];
+		}
+		if ((OPTION_CHANNELS.compare(argv[i]) == 0) && (i + 1 < argc))
+		{
+			numChannels = (size_t)atol(argv[++i]);
+		}
+		if ((OPTION_OUTPUT.compare(argv[i]) == 0) && (i + 1 < argc))
+		{
+			if (!Peaks::PeakWriter::parseFormat(argv[++i], outputFormat))
+			{
+				std::cerr << "The output format must be text, csv, jsonl or binary" << std::endl;
+				return 1;
+			}
+		}
+		if ((OPTION_LAYOUT.compare(argv[i]) == 0) && (i + 1 < argc))
+		{
+			if (!Peaks::SampleFile::parseLayout(argv[++i], layout))
+			{
+				std::cerr << "The layout must be interleaved or planar" << std::endl;
+				return 1;
+			}
+		}
+		if ((OPTION_FILTER.compare(argv[i]) == 0) && (i + 1 < argc))
+		{
+			if (!Peaks::Prefilter::parse(argv[++i], filter))
+			{
+				std::cerr << "The filter must be none, ma:<window>, ema:<alpha>, sg:<window>:<order> or median:<window>" << std::endl;
+				return 1;
+			}
+		}
 	}
 
-	if (csvFileName.length() > 0)
+	// The filters that look ahead need samples from the next block, which stream mode doesn't keep.
+	if (stream && filter.type() != Peaks::FILTER_NONE)
 	{
-		auto csvData = readThreeAxisDataFromCsv(csvFileName);
-		auto axisPeaks = findPeaks(csvData, threshold);
+		std::cerr << "--filter can't be used with --stream" << std::endl;
+		return 1;
+	}
+
+	// Only CSV files have timestamps.
+	if (timeWeighted && (stream || (csvFileName.length() == 0) || (filter.type() != Peaks::FILTER_NONE)))
+	{
+		std::cerr << "--time-weighted needs --csv, and can't be used with --stream or --filter" << std::endl;
+		return 1;
+	}
 
-		for (auto axisIter = axisPeaks.begin(); axisIter != axisPeaks.end(); ++axisIter)
+	// Job server mode: the files to search come from stdin or a socket, one job per line, instead of the command line.
+	if (serve)
+	{
+		if (!Peaks::PeakWriter::supportsJobs(outputFormat))
 		{
-			Peaks::GraphPeakList& peaks = (*axisIter);
+			std::cerr << "--serve only writes text or jsonl" << std::endl;
+			return 1;
+		}
 
-			std::cout << "Axis Peaks" << std::endl;
+		Peaks::JobServer server(outputFormat);
 
-			for (auto peakIter = peaks.begin(); peakIter != peaks.end(); ++peakIter)
-			{
-				Peaks::GraphPeak& peak = (*peakIter);
+		if (socketPath.length() > 0)
+		{
+			std::string error;
 
-				std::cout << "{ " << peak.leftTrough.x << ", " << peak.peak.x << ", " << peak.rightTrough.x << ", " << peak.area << " }" << std::endl;
-			}
+			server.listen(socketPath, error);
+			std::cerr << "Failed to listen on " << socketPath << ": " << error << std::endl;
+			return 1;
+		}
+		if (!server.serve(stdin, stdout))
+		{
+			std::cerr << "Failed to write the peaks" << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+
+	Peaks::PeakWriter writer(stdout, outputFormat);
+	Peaks::PeakStats stats;
+	uint64_t loadStart = Peaks::PeakProfiler::now();
+	uint64_t loadNanoseconds = 0;
+
+	if ((csvFileName.length() > 0) && stream)
+	{
+		if (!streamPeaks(csvFileName, numColumns, numHeaderRows, threshold, writer))
+		{
+			std::cerr << "Failed to read " << csvFileName << std::endl;
+			return 1;
+		}
+	}
+	else if (csvFileName.length() > 0)
+	{
+		Peaks::CsvLoader csv(numColumns, numHeaderRows);
+
+		if (!csv.load(csvFileName))
+		{
+			std::cerr << "Failed to read " << csvFileName << std::endl;
+			return 1;
+		}
+		loadNanoseconds = Peaks::PeakProfiler::now() - loadStart;
 
-			std::cout << std::endl;
+		std::vector<Peaks::GraphPeakList> peaks;
+		{
+			Peaks::PeakProfiler profiler(profile ? &stats : NULL);
+			if (timeWeighted)
+				peaks = findPeaksTimeWeighted(csv, threshold);
+			else
+				peaks = findPeaks(csv, threshold, filter);
+		}
+		writePeaks(writer, peaks);
+	}
+	else if ((binaryFileName.length() > 0) || (npyFileName.length() > 0))
+	{
+		Peaks::SampleFile file;
+		std::string fileName = (npyFileName.length() > 0) ? npyFileName : binaryFileName;
+		bool opened;
+
+		// In stream mode the file is only examined here, and read later.
+		if (npyFileName.length() > 0)
+			opened = file.openNpy(fileName, !stream);
+		else
+			opened = file.openRaw(fileName, dataType, numChannels, layout, !stream);
+
+		if (!opened)
+		{
+			std::cerr << "Failed to open the file: " << file.error() << std::endl;
+			return 1;
+		}
+
+		if (!stream)
+		{
+			loadNanoseconds = Peaks::PeakProfiler::now() - loadStart;
+
+			std::vector<Peaks::GraphPeakList> peaks;
+			{
+				Peaks::PeakProfiler profiler(profile ? &stats : NULL);
+				peaks = findPeaks(file, threshold, filter);
+			}
+			writePeaks(writer, peaks);
+		}
+		else if (!streamPeaks(fileName, file, threshold, writer))
+		{
+			std::cerr << "Failed to read " << fileName << std::endl;
+			return 1;
 		}
 	}
 	else
@@ -128,5 +542,15 @@ int main(int argc, const char * argv[])
 		std::cout << "" << std::endl;
 	}
 
+	if (!writer.flush())
+	{
+		std::cerr << "Failed to write the peaks" << std::endl;
+		return 1;
+	}
+
+	// The streaming finders aren't instrumented.
+	if (profile && !stream)
+		printProfile(stats, loadNanoseconds);
+
 	return 0;
 }
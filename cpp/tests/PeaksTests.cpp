@@ -0,0 +1,576 @@
+// by Michael J. Simms
+// Copyright (c) 2026 Michael J. Simms
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Regression tests for the library. Each test returns the number of failures and prints what went wrong.
+
+#include <algorithm>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "PeakHierarchy.h"
+#include "PeakIndex.h"
+#include "PeakTracker.h"
+#include "Peaks.h"
+#include "Statistics.h"
+#include "StreamingPeakFinder.h"
+#include "VectorScan.h"
+
+namespace
+{
+	const size_t SINE_SAMPLES = 20000;
+	const size_t BAD_SAMPLE = 10;
+
+	std::vector<double> sine(size_t numSamples)
+	{
+		std::vector<double> data(numSamples);
+
+		for (size_t i = 0; i < numSamples; ++i)
+			data[i] = sin((double)i * (double)0.05);
+		return data;
+	}
+
+	// Peaks whose troughs enclose the given sample.
+	bool containsSample(const Peaks::GraphPeak& peak, size_t sample)
+	{
+		return (peak.leftTrough.x < sample) && (sample <= peak.rightTrough.x);
+	}
+
+	size_t checkAreas(const char* name, const Peaks::GraphPeakList& peaks, size_t badSample)
+	{
+		size_t numFailures = 0;
+
+		for (auto iter = peaks.begin(); iter != peaks.end(); ++iter)
+		{
+			bool bad = containsSample(*iter, badSample) || containsSample(*iter, badSample + 1);
+
+			if (bad == (bool)isfinite((*iter).area))
+			{
+				printf("%s: peak at %llu has an area of %f\n", name, (unsigned long long)(*iter).peak.x, (*iter).area);
+				++numFailures;
+			}
+		}
+		return numFailures;
+	}
+
+	typedef enum TestData
+	{
+		TEST_DATA_RANDOM = 0,     // Uniform noise
+		TEST_DATA_SPARSE_SPIKES,  // Mostly flat, with the odd spike
+		TEST_DATA_PLATEAUS,       // Runs of repeated values, which exercise the <= comparisons
+		NUM_TEST_DATA
+	} TestData;
+
+	const char* TEST_DATA_NAMES[NUM_TEST_DATA] = { "random", "sparse_spikes", "plateaus" };
+
+	// Values are small whole numbers (quarters for the random data) or the int16_t extremes, so they are exact as floats,
+	// and the whole ones are exact as int16_ts.
+	std::vector<double> testData(TestData kind, size_t numSamples, uint32_t seed)
+	{
+		std::mt19937 rng(seed);
+		std::vector<double> data(numSamples);
+		double level = (double)0.0;
+
+		for (size_t i = 0; i < numSamples; ++i)
+		{
+			switch (kind)
+			{
+			case TEST_DATA_RANDOM:
+				data[i] = (double)((int)(rng() % 65) - 32) / (double)4.0;
+				break;
+			case TEST_DATA_SPARSE_SPIKES:
+				if ((rng() % 50) == 0)
+					data[i] = ((rng() % 4) == 0) ? (double)32767.0 : (double)(rng() % 8 + 1);
+				else if ((rng() % 200) == 0)
+					data[i] = (double)-32768.0;
+				else
+					data[i] = (double)((int)(rng() % 3) - 1);
+				break;
+			case TEST_DATA_PLATEAUS:
+				if ((rng() % 16) == 0)
+					level = (double)((int)(rng() % 17) - 8);
+				data[i] = level;
+				break;
+			default:
+				break;
+			}
+		}
+		return data;
+	}
+
+	// The peaks found by the plain state machine, one sample at a time, without any of the skipping or threading.
+	Peaks::GraphPeakList referencePeaks(const std::vector<double>& data, double threshold)
+	{
+		Peaks::GraphPeakList peaks;
+		Peaks::StreamingPeakFinder finder(threshold, [&peaks](const Peaks::GraphPeak& peak) { peaks.push_back(peak); });
+
+		for (auto iter = data.begin(); iter != data.end(); ++iter)
+			finder.push(*iter);
+		return peaks;
+	}
+
+	bool samePoint(const Peaks::GraphPoint& lhs, const Peaks::GraphPoint& rhs)
+	{
+		return (lhs.x == rhs.x) && (memcmp(&lhs.y, &rhs.y, sizeof(lhs.y)) == 0);
+	}
+
+	// Compares bit patterns, so that the results have to be identical rather than close.
+	size_t checkSamePeaks(const std::string& name, const Peaks::GraphPeakList& peaks, const Peaks::GraphPeakList& expected)
+	{
+		if (peaks.size() != expected.size())
+		{
+			printf("%s: %zu peaks, expected %zu\n", name.c_str(), peaks.size(), expected.size());
+			return 1;
+		}
+		for (size_t i = 0; i < peaks.size(); ++i)
+		{
+			const Peaks::GraphPeak& peak = peaks[i];
+			const Peaks::GraphPeak& other = expected[i];
+
+			if (!samePoint(peak.leftTrough, other.leftTrough) || !samePoint(peak.peak, other.peak) ||
+				!samePoint(peak.rightTrough, other.rightTrough) || (memcmp(&peak.area, &other.area, sizeof(peak.area)) != 0))
+			{
+				printf("%s: peak %zu is { %llu, %llu, %llu, %.17g }, expected { %llu, %llu, %llu, %.17g }\n", name.c_str(), i,
+					(unsigned long long)peak.leftTrough.x, (unsigned long long)peak.peak.x, (unsigned long long)peak.rightTrough.x, peak.area,
+					(unsigned long long)other.leftTrough.x, (unsigned long long)other.peak.x, (unsigned long long)other.rightTrough.x, other.area);
+				return 1;
+			}
+		}
+		return 0;
+	}
+
+	// Checks the left trough, peak and right trough of each peak against a list of sample indexes.
+	size_t checkPositions(const char* name, const Peaks::GraphPeakList& peaks, const std::vector<std::vector<uint64_t> >& expected)
+	{
+		bool same = (peaks.size() == expected.size());
+
+		for (size_t i = 0; same && i < peaks.size(); ++i)
+			same = (peaks[i].leftTrough.x == expected[i][0]) && (peaks[i].peak.x == expected[i][1]) && (peaks[i].rightTrough.x == expected[i][2]);
+		if (same)
+			return 0;
+
+		printf("%s:", name);
+		for (auto iter = peaks.begin(); iter != peaks.end(); ++iter)
+			printf(" { %llu, %llu, %llu }", (unsigned long long)(*iter).leftTrough.x, (unsigned long long)(*iter).peak.x, (unsigned long long)(*iter).rightTrough.x);
+		printf("\n");
+		return 1;
+	}
+
+	// Local maxima at 1, 3, 6 (the middle of a flat top), 9 and 11, with the highest at 9.
+	const std::vector<double> HAND_CHECKED_DATA = { 0, 3, 1, 4, 1, 2, 2, 2, 0, 5, 2, 3, 0 };
+
+	// A NaN or infinite sample only affects the area of the peak that contains it.
+	size_t testNonFiniteAreas()
+	{
+		const double badValues[] = { NAN, INFINITY, -INFINITY };
+		size_t numFailures = 0;
+
+		for (size_t i = 0; i < sizeof(badValues) / sizeof(badValues[0]); ++i)
+		{
+			std::vector<double> data = sine(SINE_SAMPLES);
+			data[BAD_SAMPLE] = badValues[i];
+
+			numFailures += checkAreas("findPeaksOverThreshold", Peaks::Peaks::findPeaksOverThreshold(data, (double)0.5), BAD_SAMPLE);
+			numFailures += checkAreas("findPeaksOverThresholdParallel", Peaks::Peaks::findPeaksOverThresholdParallel(data, (double)0.5, 4), BAD_SAMPLE);
+
+			Peaks::GraphPeakList indexed;
+			Peaks::PeakIndex index(data.data(), data.size());
+			index.findPeaksOverThreshold((double)0.5, indexed);
+			numFailures += checkAreas("PeakIndex", indexed, BAD_SAMPLE);
+
+			Peaks::GraphPeakList streamed;
+			Peaks::StreamingPeakFinder finder((double)0.5, [&streamed](const Peaks::GraphPeak& peak) { streamed.push_back(peak); });
+			finder.push(data.data(), data.size());
+			numFailures += checkAreas("StreamingPeakFinder", streamed, BAD_SAMPLE);
+		}
+		return numFailures;
+	}
+
+	// The median filter keeps NaN samples in order in its window, and a lone NaN doesn't get through it.
+	size_t testMedianNaN()
+	{
+		size_t numFailures = 0;
+		std::vector<double> data = sine(SINE_SAMPLES);
+		std::vector<double> clean = data;
+		data[BAD_SAMPLE] = NAN;
+		clean[BAD_SAMPLE] = (clean[BAD_SAMPLE - 1] + clean[BAD_SAMPLE + 1]) / (double)2.0;
+
+		Peaks::GraphPeakList peaks = Peaks::Peaks::findPeaksOverThreshold(data, Peaks::Prefilter::median(5), (double)0.5);
+		Peaks::GraphPeakList cleanPeaks = Peaks::Peaks::findPeaksOverThreshold(clean, Peaks::Prefilter::median(5), (double)0.5);
+
+		if (peaks.size() != cleanPeaks.size())
+		{
+			printf("median: %zu peaks with a NaN, against %zu without\n", peaks.size(), cleanPeaks.size());
+			++numFailures;
+		}
+		for (auto iter = peaks.begin(); iter != peaks.end(); ++iter)
+		{
+			if (!isfinite((*iter).area))
+			{
+				printf("median: peak at %llu has an area of %f\n", (unsigned long long)(*iter).peak.x, (*iter).area);
+				++numFailures;
+			}
+		}
+		return numFailures;
+	}
+
+	// Once a NaN or infinite sample has left the moving average's window, the output is the same as without it.
+	size_t testMovingAverageNaN()
+	{
+		const double badValues[] = { NAN, INFINITY, -INFINITY };
+		const uint64_t SETTLED = 200; // Well past the bad sample and the window around it
+		size_t numFailures = 0;
+		std::vector<double> clean = sine(SINE_SAMPLES);
+		Peaks::GraphPeakList cleanPeaks = Peaks::Peaks::findPeaksOverThreshold(clean, Peaks::Prefilter::movingAverage(5), (double)0.5);
+
+		for (size_t i = 0; i < sizeof(badValues) / sizeof(badValues[0]); ++i)
+		{
+			std::vector<double> data = clean;
+			data[BAD_SAMPLE] = badValues[i];
+
+			Peaks::GraphPeakList peaks = Peaks::Peaks::findPeaksOverThreshold(data, Peaks::Prefilter::movingAverage(5), (double)0.5);
+			Peaks::GraphPeakList settled;
+			Peaks::GraphPeakList cleanSettled;
+
+			for (auto iter = peaks.begin(); iter != peaks.end(); ++iter)
+			{
+				if ((*iter).leftTrough.x > SETTLED)
+					settled.push_back(*iter);
+			}
+			for (auto iter = cleanPeaks.begin(); iter != cleanPeaks.end(); ++iter)
+			{
+				if ((*iter).leftTrough.x > SETTLED)
+					cleanSettled.push_back(*iter);
+			}
+
+			if ((settled.size() != cleanSettled.size()) || !std::equal(settled.begin(), settled.end(), cleanSettled.begin()))
+			{
+				printf("moving average: %zu peaks after sample %llu with a %f, against %zu without\n", settled.size(), (unsigned long long)SETTLED, badValues[i], cleanSettled.size());
+				++numFailures;
+			}
+		}
+		return numFailures;
+	}
+
+	// The vectorized runs skip samples without changing the result: with every instruction set, the peaks in double,
+	// float and int16_t data are bit-identical to the state machine's, and so are the searches to plain loops.
+	// Thresholds between representable values check the rounding of the threshold for the narrower types.
+	size_t testVectorScan()
+	{
+		const double thresholds[] = { -40000.0, -32767.5, -8.0, -0.5, 0.0, 1e-300, 0.1, 0.250000000001, 1.0, 2.75, 3.3, 7.9, 100.0, 32766.5, 32767.0, 40000.0 };
+		const size_t NUM_SAMPLES = 5000;
+		size_t numFailures = 0;
+		Peaks::VectorStats::InstructionSet original = Peaks::VectorStats::instructionSet();
+
+		for (int set = Peaks::VectorStats::INSTRUCTION_SET_SCALAR; set <= Peaks::VectorStats::INSTRUCTION_SET_AVX512; ++set)
+		{
+			Peaks::VectorStats::InstructionSet active = Peaks::VectorStats::setInstructionSet((Peaks::VectorStats::InstructionSet)set);
+
+			// Instruction sets the CPU doesn't have are clamped to one that has already been tested.
+			if (active != (Peaks::VectorStats::InstructionSet)set)
+				continue;
+
+			for (int kind = 0; kind < NUM_TEST_DATA; ++kind)
+			{
+				std::vector<double> data = testData((TestData)kind, NUM_SAMPLES, 5 + kind);
+				std::vector<float> floats(data.begin(), data.end());
+				std::vector<int16_t> shorts(data.size());
+
+				for (size_t i = 0; i < data.size(); ++i)
+					shorts[i] = (int16_t)data[i];
+				std::vector<double> wholeData(shorts.begin(), shorts.end());
+
+				for (size_t t = 0; t < sizeof(thresholds) / sizeof(thresholds[0]); ++t)
+				{
+					double threshold = thresholds[t];
+					char buf[128];
+					snprintf(buf, sizeof(buf), "vector scan/%s/%s/%.17g", Peaks::VectorStats::instructionSetName(active), TEST_DATA_NAMES[kind], threshold);
+					std::string name = buf;
+					Peaks::GraphPeakList expected = referencePeaks(data, threshold);
+
+					numFailures += checkSamePeaks(name + "/double", Peaks::Peaks::findPeaksOverThreshold(data, threshold), expected);
+					numFailures += checkSamePeaks(name + "/float", Peaks::Peaks::findPeaksOverThreshold(Peaks::SampleView<float>(floats.data(), floats.size()), threshold), expected);
+					numFailures += checkSamePeaks(name + "/int16", Peaks::Peaks::findPeaksOverThreshold(Peaks::SampleView<int16_t>(shorts.data(), shorts.size()), threshold), referencePeaks(wholeData, threshold));
+
+					for (size_t from = 1; from < data.size(); from += 97)
+					{
+						size_t to = std::min(data.size(), from + 300);
+						size_t atOrAbove = from;
+						size_t descentEnd = from;
+
+						while ((atOrAbove < to) && (data[atOrAbove] < threshold))
+							++atOrAbove;
+						while ((descentEnd < to) && (data[descentEnd] < threshold) && (data[descentEnd] <= data[descentEnd - 1]))
+							++descentEnd;
+
+						size_t wholeAtOrAbove = from;
+						size_t wholeDescentEnd = from;
+
+						while ((wholeAtOrAbove < to) && (wholeData[wholeAtOrAbove] < threshold))
+							++wholeAtOrAbove;
+						while ((wholeDescentEnd < to) && (wholeData[wholeDescentEnd] < threshold) && (wholeData[wholeDescentEnd] <= wholeData[wholeDescentEnd - 1]))
+							++wholeDescentEnd;
+
+						if ((Peaks::VectorScan::findFirstAtOrAbove(data.data(), from, to, threshold) != atOrAbove) ||
+							(Peaks::VectorScan::findFirstAtOrAbove(floats.data(), from, to, threshold) != atOrAbove) ||
+							(Peaks::VectorScan::findFirstAtOrAbove(shorts.data(), from, to, threshold) != wholeAtOrAbove) ||
+							(Peaks::VectorScan::findEndOfDescent(data.data(), from, to, threshold) != descentEnd) ||
+							(Peaks::VectorScan::findEndOfDescent(floats.data(), from, to, threshold) != descentEnd) ||
+							(Peaks::VectorScan::findEndOfDescent(shorts.data(), from, to, threshold) != wholeDescentEnd))
+						{
+							printf("%s: searches from %zu disagree with the plain loops\n", name.c_str(), from);
+							++numFailures;
+							break;
+						}
+					}
+				}
+			}
+		}
+
+		Peaks::VectorStats::setInstructionSet(original);
+		return numFailures;
+	}
+
+	// A PeakIndex answers every threshold in a sweep, including ones equal to sample values and ones outside the
+	// data's range, with exactly the peaks of a full scan. Sample counts that aren't multiples of the block size check
+	// the partial leaves of the segment trees.
+	size_t testPeakIndex()
+	{
+		const size_t NUM_SAMPLES = 3001;
+		const size_t NUM_STEPS = 200;
+		size_t numFailures = 0;
+
+		for (int kind = 0; kind < NUM_TEST_DATA; ++kind)
+		{
+			std::vector<double> data = testData((TestData)kind, NUM_SAMPLES, 17 + kind);
+			Peaks::PeakIndex index(data.data(), data.size());
+			double minValue = *std::min_element(data.begin(), data.end());
+			double maxValue = *std::max_element(data.begin(), data.end());
+			char name[128];
+
+			for (size_t step = 0; step <= NUM_STEPS + 1; ++step)
+			{
+				// One step below the minimum, through the data's range, and one step above the maximum.
+				double threshold = minValue + (maxValue - minValue) * (double)((int)step - 1) / (double)(NUM_STEPS - 1);
+
+				snprintf(name, sizeof(name), "PeakIndex/%s/threshold %.17g", TEST_DATA_NAMES[kind], threshold);
+				numFailures += checkSamePeaks(name, index.findPeaksOverThreshold(threshold), Peaks::Peaks::findPeaksOverThreshold(data, threshold));
+			}
+			for (size_t i = 0; i < data.size(); i += 37)
+			{
+				snprintf(name, sizeof(name), "PeakIndex/%s/threshold %.17g", TEST_DATA_NAMES[kind], data[i]);
+				numFailures += checkSamePeaks(name, index.findPeaksOverThreshold(data[i]), Peaks::Peaks::findPeaksOverThreshold(data, data[i]));
+			}
+			for (double sigmas = (double)-3.0; sigmas <= (double)3.0; sigmas += (double)0.125)
+			{
+				snprintf(name, sizeof(name), "PeakIndex/%s/sigmas %.17g", TEST_DATA_NAMES[kind], sigmas);
+				numFailures += checkSamePeaks(name, index.findPeaksOverStd(sigmas), Peaks::Peaks::findPeaksOverStd(data, sigmas));
+			}
+		}
+		return numFailures;
+	}
+
+	// Splitting the data, whether into chunks on several threads or into pushes of random sizes, gives the same peaks
+	// as the serial scan. The data includes a peak that spans every chunk, which has to be stitched back together.
+	size_t testChunking()
+	{
+		const size_t NUM_SAMPLES = 60001;
+		const size_t threadCounts[] = { 2, 3, 7, 16 };
+		const double thresholds[] = { -1.0, 0.0, 0.5, 3.0 };
+		std::mt19937 rng(29);
+		size_t numFailures = 0;
+		char name[128];
+
+		std::vector<std::vector<double> > inputs;
+		for (int kind = 0; kind < NUM_TEST_DATA; ++kind)
+			inputs.push_back(testData((TestData)kind, NUM_SAMPLES, 23 + kind));
+		std::vector<double> wide(NUM_SAMPLES);
+		for (size_t i = 0; i < wide.size(); ++i)
+			wide[i] = sin((double)i * M_PI / (double)NUM_SAMPLES) * (double)10.0 + (double)((int)(i % 5) - 2) / (double)8.0;
+		inputs.push_back(wide);
+
+		for (size_t input = 0; input < inputs.size(); ++input)
+		{
+			const std::vector<double>& data = inputs[input];
+			const char* dataName = (input < NUM_TEST_DATA) ? TEST_DATA_NAMES[input] : "wide";
+
+			for (size_t t = 0; t < sizeof(thresholds) / sizeof(thresholds[0]); ++t)
+			{
+				double threshold = thresholds[t];
+				Peaks::GraphPeakList expected = Peaks::Peaks::findPeaksOverThreshold(data, threshold);
+
+				for (size_t n = 0; n < sizeof(threadCounts) / sizeof(threadCounts[0]); ++n)
+				{
+					snprintf(name, sizeof(name), "parallel/%s/%g/%zu threads", dataName, threshold, threadCounts[n]);
+					numFailures += checkSamePeaks(name, Peaks::Peaks::findPeaksOverThresholdParallel(data, threshold, threadCounts[n]), expected);
+				}
+
+				Peaks::GraphPeakList streamed;
+				Peaks::StreamingPeakFinder finder(threshold, [&streamed](const Peaks::GraphPeak& peak) { streamed.push_back(peak); });
+
+				for (size_t i = 0; i < data.size(); )
+				{
+					// Mostly small pushes, with the odd one longer than a block of the area prefix.
+					size_t len = ((rng() % 8) == 0) ? (size_t)(rng() % 10000) : (size_t)(rng() % 64);
+					len = std::min(len, data.size() - i);
+					finder.push(data.data() + i, len);
+					i += len;
+				}
+				snprintf(name, sizeof(name), "streaming/%s/%g/random chunks", dataName, threshold);
+				numFailures += checkSamePeaks(name, streamed, expected);
+			}
+		}
+		return numFailures;
+	}
+
+	// The bases and prominences are the ones scipy.signal.peak_prominences gives, worked out by hand: a base is the
+	// lowest sample between the peak and the nearest higher sample (or the end), the one nearest the peak on a tie.
+	size_t testProminence()
+	{
+		size_t numFailures = 0;
+		Peaks::GraphPeakList peaks = Peaks::Peaks::findPeaksByProminence(HAND_CHECKED_DATA);
+		const double prominences[] = { 2.0, 4.0, 1.0, 5.0, 1.0 };
+
+		numFailures += checkPositions("prominence", peaks, { { 0, 1, 2 }, { 0, 3, 8 }, { 4, 6, 8 }, { 8, 9, 12 }, { 10, 11, 12 } });
+		for (size_t i = 0; i < peaks.size() && i < 5; ++i)
+		{
+			if (Peaks::Peaks::prominence(peaks[i]) != prominences[i])
+			{
+				printf("prominence: peak at %llu has a prominence of %f, expected %f\n", (unsigned long long)peaks[i].peak.x, Peaks::Peaks::prominence(peaks[i]), prominences[i]);
+				++numFailures;
+			}
+		}
+
+		Peaks::ProminenceOptions options;
+		options.minProminence = (double)1.5;
+		numFailures += checkPositions("prominence/min", Peaks::Peaks::findPeaksByProminence(HAND_CHECKED_DATA, options), { { 0, 1, 2 }, { 0, 3, 8 }, { 8, 9, 12 } });
+		options.rankByProminence = true;
+		numFailures += checkPositions("prominence/ranked", Peaks::Peaks::findPeaksByProminence(HAND_CHECKED_DATA, options), { { 8, 9, 12 }, { 0, 3, 8 }, { 0, 1, 2 } });
+		return numFailures;
+	}
+
+	// Lowering a water line over the same data: 11 joins 9 at 10, 6 joins 3 at 4, 1 joins 3 at 2, and 3 joins 9 at 8.
+	size_t testPeakHierarchy()
+	{
+		size_t numFailures = 0;
+		Peaks::PeakHierarchy hierarchy(HAND_CHECKED_DATA.data(), HAND_CHECKED_DATA.size());
+		const size_t peaks[] = { 1, 3, 6, 9, 11 };
+		const double persistences[] = { 2.0, 4.0, 1.0, 5.0, 1.0 };
+		const size_t parents[] = { 1, 3, 1, Peaks::PeakHierarchy::NO_PARENT, 3 };
+
+		if (hierarchy.size() != 5 || hierarchy.root() != 3)
+		{
+			printf("hierarchy: %zu peaks with the root at %zu, expected 5 with the root at 3\n", hierarchy.size(), hierarchy.root());
+			return 1;
+		}
+		for (size_t i = 0; i < hierarchy.size(); ++i)
+		{
+			const Peaks::PeakHierarchy::Node& node = hierarchy.node(i);
+
+			if (node.peak != peaks[i] || node.persistence != persistences[i] || node.parent != parents[i])
+			{
+				printf("hierarchy: node %zu is at %zu with a persistence of %f and parent %zu\n", i, node.peak, node.persistence, node.parent);
+				++numFailures;
+			}
+		}
+
+		// The tie between 6 and 11 goes to the earlier peak.
+		numFailures += checkPositions("hierarchy/top 3", hierarchy.topByPersistence(3), { { 0, 9, 12 }, { 0, 3, 8 }, { 0, 1, 2 } });
+		numFailures += checkPositions("hierarchy/top 5", hierarchy.topByPersistence(5), { { 0, 9, 12 }, { 0, 3, 8 }, { 0, 1, 2 }, { 4, 6, 8 }, { 10, 11, 12 } });
+		numFailures += checkPositions("hierarchy/persistence", hierarchy.peaksOverPersistence((double)2.0), { { 0, 1, 2 }, { 0, 3, 8 }, { 0, 9, 12 } });
+		return numFailures;
+	}
+
+	// Two tracks that each miss a frame and come back, one that misses two frames and ends, and the order of the events.
+	size_t testPeakTracker()
+	{
+		std::vector<std::string> events;
+		Peaks::PeakTracker tracker(2, 1, [&events](Peaks::PeakTracker::TrackEvent event, const Peaks::PeakTracker::Track& track) {
+			char buf[64];
+			snprintf(buf, sizeof(buf), "%s %llu at %llu, %llu peaks", (event == Peaks::PeakTracker::TRACK_BIRTH) ? "birth" : "death",
+				(unsigned long long)track.id, (unsigned long long)track.lastPeak.peak.x, (unsigned long long)track.numPeaks());
+			events.push_back(buf);
+		});
+		const std::vector<std::vector<uint64_t> > frames = { { 10, 50 }, { 11, 80 }, { 12, 51 }, { 13 }, {} };
+		const std::vector<std::vector<uint64_t> > frameTrackIds = { { 0, 1 }, { 0, 2 }, { 0, 1 }, { 0 }, {} };
+		const std::vector<std::string> expected = {
+			"birth 0 at 10, 1 peaks", "birth 1 at 50, 1 peaks",
+			"birth 2 at 80, 1 peaks",
+			"death 2 at 80, 1 peaks",
+			"death 1 at 51, 2 peaks",
+			"death 0 at 13, 4 peaks"
+		};
+		size_t numFailures = 0;
+
+		for (size_t frame = 0; frame < frames.size(); ++frame)
+		{
+			Peaks::GraphPeakList peaks;
+
+			for (auto iter = frames[frame].begin(); iter != frames[frame].end(); ++iter)
+			{
+				Peaks::GraphPeak peak;
+				peak.leftTrough = Peaks::GraphPoint(*iter - 1, (double)0.0);
+				peak.peak = Peaks::GraphPoint(*iter, (double)1.0);
+				peak.rightTrough = Peaks::GraphPoint(*iter + 1, (double)0.0);
+				peaks.push_back(peak);
+			}
+			tracker.update(peaks);
+			if (tracker.frameTrackIds() != frameTrackIds[frame])
+			{
+				printf("tracker: the peaks of frame %zu went to the wrong tracks\n", frame);
+				++numFailures;
+			}
+		}
+		tracker.finish();
+
+		if (events != expected || tracker.numTracksStarted() != 3 || !tracker.tracks().empty())
+		{
+			printf("tracker: events were");
+			for (auto iter = events.begin(); iter != events.end(); ++iter)
+				printf(" [%s]", (*iter).c_str());
+			printf("\n");
+			++numFailures;
+		}
+		return numFailures;
+	}
+}
+
+int main()
+{
+	size_t numFailures = 0;
+
+	numFailures += testNonFiniteAreas();
+	numFailures += testMedianNaN();
+	numFailures += testMovingAverageNaN();
+	numFailures += testVectorScan();
+	numFailures += testPeakIndex();
+	numFailures += testChunking();
+	numFailures += testProminence();
+	numFailures += testPeakHierarchy();
+	numFailures += testPeakTracker();
+
+	if (numFailures > 0)
+		printf("%zu failures\n", numFailures);
+	return (numFailures == 0) ? 0 : 1;
+}